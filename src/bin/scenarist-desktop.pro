@@ -369,7 +369,12 @@ SOURCES += \
     scenarist-core/UserInterfaceLayer/ScriptVersions/ScriptVersionWidget.cpp \
     scenarist-core/UserInterfaceLayer/ScriptVersions/ScriptVersionsList.cpp \
     scenarist-core/BusinessLayer/Tools/CompareScriptVersionsTool.cpp \
-    scenarist-desktop/UserInterfaceLayer/Scenario/ScenarioItemDialog/ScenarioItemDialog.cpp
+    scenarist-desktop/UserInterfaceLayer/Scenario/ScenarioItemDialog/ScenarioItemDialog.cpp \
+    scenarist-desktop/ManagementLayer/Scenario/ScriptNamesIndex.cpp \
+    scenarist-desktop/ManagementLayer/Scenario/ScenarioChangesScheduler.cpp \
+    scenarist-desktop/ManagementLayer/Scenario/ScriptDurationIndex.cpp \
+    scenarist-desktop/ManagementLayer/Scenario/ScriptBlocksRange.cpp \
+    scenarist-desktop/ManagementLayer/Research/ResearchImagesCache.cpp
 
 HEADERS += \
     scenarist-desktop/ManagementLayer/ApplicationManager.h \
@@ -650,7 +655,12 @@ HEADERS += \
     scenarist-core/UserInterfaceLayer/ScriptVersions/ScriptVersionWidget.h \
     scenarist-core/UserInterfaceLayer/ScriptVersions/ScriptVersionsList.h \
     scenarist-core/BusinessLayer/Tools/CompareScriptVersionsTool.h \
-    scenarist-desktop/UserInterfaceLayer/Scenario/ScenarioItemDialog/ScenarioItemDialog.h
+    scenarist-desktop/UserInterfaceLayer/Scenario/ScenarioItemDialog/ScenarioItemDialog.h \
+    scenarist-desktop/ManagementLayer/Scenario/ScriptNamesIndex.h \
+    scenarist-desktop/ManagementLayer/Scenario/ScenarioChangesScheduler.h \
+    scenarist-desktop/ManagementLayer/Scenario/ScriptDurationIndex.h \
+    scenarist-desktop/ManagementLayer/Scenario/ScriptBlocksRange.h \
+    scenarist-desktop/ManagementLayer/Research/ResearchImagesCache.h
 
 FORMS += \
     scenarist-desktop/UserInterfaceLayer/StartUp/StartUpView.ui \
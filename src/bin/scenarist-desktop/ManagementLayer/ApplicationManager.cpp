@@ -662,6 +662,12 @@ void ApplicationManager::aboutSave()
         // А если ошибка сохранения, то делаем дополнительные проверки и работаем с пользователем
         //
         else {
+            //
+            // Изменения не попали в базу, поэтому при следующей попытке сохраняем всё заново
+            //
+            m_researchManager->markResearchChanged();
+            m_scenarioManager->markCurrentProjectChanged();
+
             //
             // Если файл, в который мы пробуем сохранять изменения существует
             //
@@ -1408,6 +1414,11 @@ void ApplicationManager::aboutSyncClosedWithError(int _errorCode, const QString&
 
 void ApplicationManager::aboutImport()
 {
+    //
+    // Импорт работает со всеми данными проекта, поэтому они должны быть полностью загружены
+    //
+    finishProjectLoading();
+
     m_state = ApplicationState::Importing;
     m_importManager->importScenario(m_scenarioManager->scenario(), m_scenarioManager->cursorPosition());
     m_researchManager->loadScenarioData();
@@ -1792,22 +1803,51 @@ void ApplicationManager::goToEditCurrentProject(const QString& _importFilePath)
     }
 
     //
-    // FIXME: Если были изменения связанные с текстом сценария перестраиваем карточки
-    //        т.к. там нет пока синхронизации
+    // Остальные части проекта загружаем поэтапно, уже после того, как текст сценария будет показан,
+    // чтобы пользователь мог начать работу, не дожидаясь их загрузки
+    //
+    // NOTE: Загружать данные нужно после того, как все данные синхронизировались
     //
-    m_scenarioManager->rebuildCardsFromScript();
+    // ... FIXME: Если были изменения связанные с текстом сценария перестраиваем карточки
+    //            т.к. там нет пока синхронизации
+    //
+    m_projectLoadingSteps.enqueue([this] {
+        m_scenarioManager->rebuildCardsFromScript();
+    });
+    //
+    // ... разработка и зависящие от неё параметры сценария
+    //
+    m_projectLoadingSteps.enqueue([this] {
+        m_researchManager->loadCurrentProject();
+        m_researchManager->loadCurrentProjectSettings(ProjectsManager::currentProject().path());
+
+        //
+        // Обновим название текущего проекта, т.к. данные о проекте теперь загружены
+        //
+        updateWindowTitle();
 
+        //
+        // Установим параметры между менеджерами
+        //
+        m_scenarioManager->setSceneNumbersPrefix(m_researchManager->sceneNumbersPrefix());
+        m_scenarioManager->setSceneStartNumber(m_researchManager->sceneStartNumber());
+    });
     //
-    // Загрузить данные из файла
-    // Делать это нужно после того, как все данные синхронизировались
+    // ... статистика
     //
-    m_researchManager->loadCurrentProject();
-    m_statisticsManager->loadCurrentProject();
+    m_projectLoadingSteps.enqueue([this] {
+        m_statisticsManager->loadCurrentProject();
+    });
 
     //
     // Затем импортируем данные из указанного файла, если необходимо
     //
     if (!_importFilePath.isEmpty()) {
+        //
+        // ... импорт работает со всеми данными проекта, поэтому загружаем их сразу
+        //
+        finishProjectLoading();
+
         progress.setProgressText(tr("Import"), tr("Please wait. Import can take few minutes."));
         m_importManager->importScenario(m_scenarioManager->scenario(), _importFilePath);
         m_researchManager->loadScenarioData();
@@ -1816,29 +1856,18 @@ void ApplicationManager::goToEditCurrentProject(const QString& _importFilePath)
     //
     // Запускаем обработку изменений сценария
     //
-    m_scenarioManager->startChangesHandling();
+    m_scenarioManager->startChangesHandling(ProjectsManager::currentProject().isRemote());
 
     //
     // Загрузить настройки файла
     // Порядок загрузки важен - сначала настройки каждого модуля, потом активные вкладки
+    // Настройки разработки загружаются вместе с ней
     //
-    m_researchManager->loadCurrentProjectSettings(ProjectsManager::currentProject().path());
     m_scenarioManager->loadCurrentProjectSettings(ProjectsManager::currentProject().path());
     m_exportManager->loadCurrentProjectSettings(ProjectsManager::currentProject().path());
     m_toolsManager->loadCurrentProjectSettings();
     loadCurrentProjectSettings(ProjectsManager::currentProject().path());
 
-    //
-    // Обновим название текущего проекта, т.к. данные о проекте теперь загружены
-    //
-    updateWindowTitle();
-
-    //
-    // Установим параметры между менеджерами
-    //
-    m_scenarioManager->setSceneNumbersPrefix(m_researchManager->sceneNumbersPrefix());
-    m_scenarioManager->setSceneStartNumber(m_researchManager->sceneStartNumber());
-
     //
     // Обновим информацию о последнем изменении
     //
@@ -1857,14 +1886,50 @@ void ApplicationManager::goToEditCurrentProject(const QString& _importFilePath)
     // После того, как все данные загружены и синхронизированы, сохраняем проект
     //
     if (m_projectsManager->currentProject().isRemote()) {
-        updateWindowModified(m_view, true);
-        aboutSave();
+        m_projectLoadingSteps.enqueue([this] {
+            updateWindowModified(m_view, true);
+            aboutSave();
+        });
+    }
+
+    //
+    // Запускаем загрузку оставшихся частей проекта
+    //
+    QTimer::singleShot(0, this, &ApplicationManager::loadNextProjectPart);
+}
+
+void ApplicationManager::loadNextProjectPart()
+{
+    if (m_projectLoadingSteps.isEmpty()) {
+        return;
+    }
+
+    //
+    // Каждый этап выполняем в отдельной итерации цикла событий, чтобы между ними
+    // приложение успевало обработать действия пользователя
+    //
+    m_projectLoadingSteps.dequeue()();
+
+    if (!m_projectLoadingSteps.isEmpty()) {
+        QTimer::singleShot(0, this, &ApplicationManager::loadNextProjectPart);
+    }
+}
+
+void ApplicationManager::finishProjectLoading()
+{
+    while (!m_projectLoadingSteps.isEmpty()) {
+        m_projectLoadingSteps.dequeue()();
     }
 }
 
 void ApplicationManager::closeCurrentProject()
 {
     if (isProjectLoaded()) {
+        //
+        // Дозагрузим части проекта, которые не успели загрузиться, чтобы корректно сохранить их настройки
+        //
+        finishProjectLoading();
+
         //
         // Сохраним настройки закрываемого проекта
         //
@@ -2191,6 +2256,8 @@ void ApplicationManager::initConnections()
             m_scenarioManager, &ScenarioManager::aboutNavigatorSettingsUpdated);
     connect(m_settingsManager, &SettingsManager::chronometrySettingsUpdated,
             m_scenarioManager, &ScenarioManager::aboutChronometrySettingsUpdated);
+    connect(m_settingsManager, &SettingsManager::chronometrySettingsUpdated,
+            m_statisticsManager, &StatisticsManager::resetCache);
     connect(m_settingsManager, &SettingsManager::countersSettingsUpdated,
             m_scenarioManager, &ScenarioManager::aboutCountersSettingsUpdated);
     connect(m_settingsManager, &SettingsManager::scenarioEditSettingsUpdated, m_toolsManager, &ToolsManager::reloadTextEditSettings);
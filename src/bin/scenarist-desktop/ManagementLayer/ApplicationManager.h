@@ -4,8 +4,11 @@
 #include <3rd_party/Helpers/BackupHelper.h>
 
 #include <QObject>
+#include <QQueue>
 #include <QTimer>
 
+#include <functional>
+
 class FlatButton;
 class SideTabBar;
 class QLabel;
@@ -257,6 +260,16 @@ namespace ManagementLayer
          */
         void goToEditCurrentProject(const QString& _importFilePath = QString());
 
+        /**
+         * @brief Загрузить следующую часть текущего проекта
+         */
+        void loadNextProjectPart();
+
+        /**
+         * @brief Загрузить сразу все оставшиеся части текущего проекта
+         */
+        void finishProjectLoading();
+
         /**
          * @brief Закрыть текущий проект
          */
@@ -421,6 +434,11 @@ namespace ManagementLayer
          */
         BackupHelper m_backupHelper;
 
+        /**
+         * @brief Отложенные этапы загрузки текущего проекта
+         */
+        QQueue<std::function<void()>> m_projectLoadingSteps;
+
         /**
          * @brief Состояние приложения в данный момент
          */
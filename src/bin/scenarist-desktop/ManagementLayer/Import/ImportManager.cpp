@@ -1,5 +1,7 @@
 #include "ImportManager.h"
 
+#include <ManagementLayer/Scenario/ScriptNamesIndex.h>
+
 #include <Domain/Research.h>
 #include <Domain/Scenario.h>
 
@@ -27,8 +29,13 @@
 #include <QApplication>
 #include <QFile>
 #include <QSet>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <functional>
 
 using ManagementLayer::ImportManager;
+using ManagementLayer::ScriptNamesIndex;
 using UserInterface::ImportDialog;
 
 namespace {
@@ -50,57 +57,228 @@ namespace {
     /** @} */
 
     /**
-     * @brief Сохранить импортированный документ разработки со вложенными документами
+     * @brief Собрать данные изображений документов разработки со всеми вложенными документами
      */
-    static void storeResearchDocument(const QVariantMap& _documentData, Domain::Research* _parent) {
-        //
-        // Т.к. разработка может быть довольно большой, то нужно давать выполняться гуи-потоку,
-        // чтобы не было ощущения зависания
-        //
-        QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    static void collectResearchImagesData(const QVariantList& _documentsData, QList<QByteArray>& _imagesData) {
+        for (const QVariant& documentData : _documentsData) {
+            const QVariantMap documentMap = documentData.toMap();
+            if (documentMap.contains("image")) {
+                _imagesData.append(documentMap["image"].toByteArray());
+            }
+            collectResearchImagesData(documentMap["childs"].toList(), _imagesData);
+        }
+    }
+
+    /**
+     * @brief Декодировать изображение
+     */
+    static QImage imageFromBytes(const QByteArray& _bytes) {
+        return QImage::fromData(_bytes);
+    }
 
+    /**
+     * @brief Декодер изображений импортируемой разработки
+     *
+     * Декодирование больших фотографий - самая затратная часть импорта разработки, поэтому
+     * изображения декодируются в фоновых потоках окнами ограниченного размера: пока сохраняются
+     * изображения текущего окна, декодируется следующее. Так в памяти одновременно находятся
+     * не более двух окон декодированных изображений, а не вся разработка.
+     *
+     * Изображения отдаются по порядку обхода разработки: персонажи, локации, документы,
+     * каждый элемент раньше своих вложенных элементов. В том же порядке их запрашивает
+     * сохранение разработки.
+     */
+    class ResearchImagesDecoder
+    {
+    public:
+        explicit ResearchImagesDecoder(const QVariantMap& _research) :
+            m_windowSize(qMax(2, QThread::idealThreadCount()))
+        {
+            for (const QVariant& character : _research["characters"].toList()) {
+                collectResearchImagesData(character.toMap()["childs"].toList(), m_imagesData);
+            }
+            for (const QVariant& location : _research["locations"].toList()) {
+                collectResearchImagesData(location.toMap()["childs"].toList(), m_imagesData);
+            }
+            collectResearchImagesData(_research["documents"].toList(), m_imagesData);
+
+            decodeNextWindow();
+        }
+
+        ~ResearchImagesDecoder() {
+            m_nextWindow.cancel();
+            m_nextWindow.waitForFinished();
+        }
+
+        /**
+         * @brief Получить очередное изображение
+         * @note Если изображение не удалось декодировать, то возвращается пустое изображение
+         */
+        QImage takeNext() {
+            if (m_imageIndex >= m_imagesData.size()) {
+                return QImage();
+            }
+
+            const int windowIndex = m_imageIndex - m_windowStart;
+            if (windowIndex >= m_window.size()) {
+                m_windowStart += m_window.size();
+                m_window = waitForWindow(m_nextWindow);
+                decodeNextWindow();
+                return takeNext();
+            }
+
+            //
+            // Отданное изображение больше не нужно декодеру, поэтому сразу освобождаем его
+            //
+            ++m_imageIndex;
+            QImage image;
+            m_window[windowIndex].swap(image);
+            return image;
+        }
+
+    private:
+        /**
+         * @brief Запустить декодирование окна, следующего за текущим
+         */
+        void decodeNextWindow() {
+            const int nextWindowStart = m_windowStart + m_window.size();
+            m_nextWindow = QtConcurrent::mapped(m_imagesData.mid(nextWindowStart, m_windowSize), imageFromBytes);
+        }
+
+        /**
+         * @brief Дождаться декодирования окна
+         *
+         * Ждём, не запуская цикл событий, т.к. разработка сохраняется одной открытой транзакцией,
+         * и таймеры, или отложенные вызовы не должны успеть обратиться к базе данных. Пока
+         * сохраняется текущее окно, следующее уже декодируется, поэтому ждать обычно не приходится
+         */
+        static QList<QImage> waitForWindow(const QFuture<QImage>& _window) {
+            return _window.results();
+        }
+
+    private:
+        /**
+         * @brief Размер окна декодирования
+         */
+        const int m_windowSize;
+
+        /**
+         * @brief Данные всех изображений разработки в порядке обхода
+         * @note Массивы байт разделяются с данными разработки и не копируются
+         */
+        QList<QByteArray> m_imagesData;
+
+        /**
+         * @brief Номер следующего отдаваемого изображения
+         */
+        int m_imageIndex = 0;
+
+        /**
+         * @brief Номер первого изображения текущего окна
+         */
+        int m_windowStart = 0;
+
+        /**
+         * @brief Декодированные изображения текущего окна
+         */
+        QList<QImage> m_window;
+
+        /**
+         * @brief Декодирование следующего окна
+         */
+        QFuture<QImage> m_nextWindow;
+    };
+
+    /**
+     * @brief Посчитать количество документов разработки со всеми вложенными документами
+     */
+    static int researchDocumentsCount(const QVariantList& _documentsData) {
+        int count = _documentsData.size();
+        for (const QVariant& documentData : _documentsData) {
+            count += researchDocumentsCount(documentData.toMap()["childs"].toList());
+        }
+        return count;
+    }
+
+    /**
+     * @brief Данные, общие для сохранения всех элементов импортируемой разработки
+     */
+    struct ResearchImportContext
+    {
+        /**
+         * @brief Декодер изображений разработки
+         */
+        ResearchImagesDecoder* images = nullptr;
+
+        /**
+         * @brief Уведомление о сохранении очередного элемента разработки
+         */
+        std::function<void()> itemStored;
+    };
+
+    /**
+     * @brief Сохранить импортированный документ разработки со вложенными документами
+     * @param _row - позиция документа среди соседей, используется, если порядок сортировки не задан
+     */
+    static void storeResearchDocument(const QVariantMap& _documentData, Domain::Research* _parent,
+        int _row, const ResearchImportContext& _context) {
         //
         // Загружаем базовые поля
         //
         const int type = _documentData["type"].toInt();
-        const int sortOrder = _documentData["sort_order"].toInt();
+        const int sortOrder = _documentData.value("sort_order", _row).toInt();
         const QString name = _documentData["name"].toString();
         auto* document = DataStorageLayer::StorageFacade::researchStorage()->storeResearch(_parent, type, sortOrder, name);
         //
-        // Установим описание
+        // Установим описание, если есть
         //
-        document->setDescription(_documentData["description"].toString());
+        bool hasAdditionalData = false;
+        const QString description = _documentData["description"].toString();
+        if (!description.isEmpty()) {
+            document->setDescription(description);
+            hasAdditionalData = true;
+        }
         //
         // Установим ссылку, если есть
         //
         if (_documentData.contains("url")) {
             document->setUrl(_documentData["url"].toString());
+            hasAdditionalData = true;
         }
         //
         // Установим картинку, если есть
         //
         if (_documentData.contains("image")) {
-            document->setImage(ImageHelper::imageFromBytes(_documentData["image"].toByteArray()));
+            const QByteArray imageData = _documentData["image"].toByteArray();
+            const QImage image = _context.images->takeNext();
+            if (!image.isNull()) {
+                document->setImage(QPixmap::fromImage(image));
+            } else {
+                document->setImage(ImageHelper::imageFromBytes(imageData));
+            }
+            hasAdditionalData = true;
         }
         //
-        // И обновим, т.к. добавились дополнительные данные
+        // И обновим, если добавились дополнительные данные
         //
-        DataStorageLayer::StorageFacade::researchStorage()->updateResearch(document);
+        if (hasAdditionalData) {
+            DataStorageLayer::StorageFacade::researchStorage()->updateResearch(document);
+        }
+        _context.itemStored();
 
         //
         // Загрузим дочерние элементы, если есть
         //
-        if (_documentData.contains("childs")) {
-            for (const QVariant& childDocumentData : _documentData["childs"].toList()) {
-                storeResearchDocument(childDocumentData.toMap(), document);
-            }
+        const QVariantList childsData = _documentData["childs"].toList();
+        for (int row = 0; row < childsData.size(); ++row) {
+            storeResearchDocument(childsData.at(row).toMap(), document, row, _context);
         }
     }
 
     /**
      * @brief Сохранить импортированного персонажа
      */
-    static void storeCharacter(const QVariantMap& _characterData) {
+    static void storeCharacter(const QVariantMap& _characterData, const ResearchImportContext& _context) {
         //
         // Загрузим данные
         //
@@ -114,16 +292,18 @@ namespace {
         // И обновим, т.к. добавились дополнительные данные
         //
         DataStorageLayer::StorageFacade::researchStorage()->updateCharacter(character);
+        _context.itemStored();
 
-        for (const QVariant& childDocumentData : _characterData["childs"].toList()) {
-            storeResearchDocument(childDocumentData.toMap(), character);
+        const QVariantList childsData = _characterData["childs"].toList();
+        for (int row = 0; row < childsData.size(); ++row) {
+            storeResearchDocument(childsData.at(row).toMap(), character, row, _context);
         }
     }
 
     /**
      * @brief Сохранить импортированную локацию
      */
-    static void storeLocation(const QVariantMap& _locationData) {
+    static void storeLocation(const QVariantMap& _locationData, const ResearchImportContext& _context) {
         //
         // Загрузим данные
         //
@@ -137,9 +317,11 @@ namespace {
         // И обновим, т.к. добавились дополнительные данные
         //
         DataStorageLayer::StorageFacade::researchStorage()->updateLocation(location);
+        _context.itemStored();
 
-        for (const QVariant& childDocumentData : _locationData["childs"].toList()) {
-            storeResearchDocument(childDocumentData.toMap(), location);
+        const QVariantList childsData = _locationData["childs"].toList();
+        for (int row = 0; row < childsData.size(); ++row) {
+            storeResearchDocument(childsData.at(row).toMap(), location, row, _context);
         }
     }
 }
@@ -217,82 +399,50 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
     //
     if (_importParameters.findCharactersAndLocations) {
         //
-        // Персонажи
-        //
-        {
-            const QSet<QString> characters = QSet<QString>::fromList(_scenario->findCharacters());
-
-            //
-            // Определить персонажи, которых нет в тексте
-            //
-            QSet<QString> charactersToDelete;
-            foreach (DomainObject* domainObject,
-                     DataStorageLayer::StorageFacade::researchStorage()->characters()->toList()) {
-                Research* character = dynamic_cast<Research*>(domainObject);
-                if (!characters.contains(character->name())) {
-                    charactersToDelete.insert(character->name());
-                }
-            }
-
-            //
-            // Удалить тех, кого нет
-            //
-            DatabaseLayer::Database::transaction();
-            foreach (const QString& character, charactersToDelete) {
-                DataStorageLayer::StorageFacade::researchStorage()->removeCharacter(character);
-            }
-            DatabaseLayer::Database::commit();
-
-            //
-            // Добавить новых
-            //
-            DatabaseLayer::Database::transaction();
-            foreach (const QString& character, characters) {
-                if (!DataStorageLayer::StorageFacade::researchStorage()->hasCharacter(character)) {
-                    DataStorageLayer::StorageFacade::researchStorage()->storeCharacter(character);
-                }
-            }
-            DatabaseLayer::Database::commit();
+        // Если у документа есть индекс имён, то берём персонажей и локации из него,
+        // чтобы не разбирать повторно весь текст
+        //
+        QSet<QString> characters;
+        QSet<QString> locations;
+        if (ScriptNamesIndex* namesIndex = _scenario->document()->findChild<ScriptNamesIndex*>()) {
+            characters = namesIndex->characters();
+            locations = namesIndex->locations();
+        } else {
+            characters = QSet<QString>::fromList(_scenario->findCharacters());
+            locations = QSet<QString>::fromList(_scenario->findLocations());
         }
 
         //
-        // Локации
+        // Определить персонажей и локации, которых нет в тексте, и новые
         //
-        {
-            const QSet<QString> locations = QSet<QString>::fromList(_scenario->findLocations());
-
-            //
-            // Определить локации, которых нет в тексте
-            //
-            QSet<QString> locationsToDelete;
-            foreach (DomainObject* domainObject,
-                     DataStorageLayer::StorageFacade::researchStorage()->locations()->toList()) {
-                Research* location = dynamic_cast<Research*>(domainObject);
-                if (!locations.contains(location->name())) {
-                    locationsToDelete.insert(location->name());
-                }
-            }
-
-            //
-            // Удалить те, которых нет
-            //
-            DatabaseLayer::Database::transaction();
-            foreach (const QString& location, locationsToDelete) {
-                DataStorageLayer::StorageFacade::researchStorage()->removeLocation(location);
-            }
-            DatabaseLayer::Database::commit();
+        QSet<QString> storedCharacters;
+        foreach (DomainObject* domainObject,
+                 DataStorageLayer::StorageFacade::researchStorage()->characters()->toList()) {
+            storedCharacters.insert(dynamic_cast<Research*>(domainObject)->name());
+        }
+        QSet<QString> storedLocations;
+        foreach (DomainObject* domainObject,
+                 DataStorageLayer::StorageFacade::researchStorage()->locations()->toList()) {
+            storedLocations.insert(dynamic_cast<Research*>(domainObject)->name());
+        }
 
-            //
-            // Добавить новых
-            //
-            DatabaseLayer::Database::transaction();
-            foreach (const QString& location, locations) {
-                if (!DataStorageLayer::StorageFacade::researchStorage()->hasLocation(location)) {
-                    DataStorageLayer::StorageFacade::researchStorage()->storeLocation(location);
-                }
-            }
-            DatabaseLayer::Database::commit();
+        //
+        // Применить все изменения одной транзакцией
+        //
+        DatabaseLayer::Database::transaction();
+        foreach (const QString& character, storedCharacters - characters) {
+            DataStorageLayer::StorageFacade::researchStorage()->removeCharacter(character);
+        }
+        foreach (const QString& character, characters - storedCharacters) {
+            DataStorageLayer::StorageFacade::researchStorage()->storeCharacter(character);
+        }
+        foreach (const QString& location, storedLocations - locations) {
+            DataStorageLayer::StorageFacade::researchStorage()->removeLocation(location);
+        }
+        foreach (const QString& location, locations - storedLocations) {
+            DataStorageLayer::StorageFacade::researchStorage()->storeLocation(location);
         }
+        DatabaseLayer::Database::commit();
     }
 
 
@@ -301,6 +451,43 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
     //
     const QVariantMap research = importer->importResearch(_importParameters);
     if (!research.isEmpty()) {
+        const QVariantList characters = research["characters"].toList();
+        const QVariantList locations = research["locations"].toList();
+        const QVariantList documents = research["documents"].toList();
+
+        //
+        // Подготовим изображения и уведомление о ходе импорта, которое обновляет прогресс
+        // только при изменении процента, а не на каждом элементе
+        //
+        ResearchImagesDecoder images(research);
+        ResearchImportContext context;
+        context.images = &images;
+        const int itemsCount =
+                ::researchDocumentsCount(characters)
+                + ::researchDocumentsCount(locations)
+                + ::researchDocumentsCount(documents);
+        int storedItemsCount = 0;
+        int lastProgress = -1;
+        context.itemStored = [itemsCount, &storedItemsCount, &lastProgress] {
+            ++storedItemsCount;
+            const int progress = storedItemsCount * 100 / qMax(1, itemsCount);
+            if (progress != lastProgress) {
+                lastProgress = progress;
+                QLightBoxProgress::setProgressValue(progress);
+                //
+                // Перерисовываем уведомление, чтобы не было ощущения зависания, но цикл событий
+                // не запускаем: таймеры и отложенные вызовы, например, автосохранение,
+                // не должны писать в базу данных посреди открытой транзакции импорта
+                //
+                QApplication::sendPostedEvents(nullptr, QEvent::UpdateRequest);
+            }
+        };
+
+        //
+        // Вся разработка сохраняется одной транзакцией
+        //
+        DatabaseLayer::Database::transaction();
+
         //
         // Данные сценария
         //
@@ -319,35 +506,28 @@ bool ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
         //
         // Персонажи
         //
-        {
-            QLightBoxProgress::setProgressText(tr("Characters import"), QString());
-            const QVariantList characters = research["characters"].toList();
-            for (const QVariant& character : characters) {
-                ::storeCharacter(character.toMap());
-            }
+        QLightBoxProgress::setProgressText(tr("Characters import"), QString());
+        for (const QVariant& character : characters) {
+            ::storeCharacter(character.toMap(), context);
         }
 
         //
         // Локации
         //
-        {
-            QLightBoxProgress::setProgressText(tr("Locations import"), QString());
-            const QVariantList locations = research["locations"].toList();
-            for (const QVariant& location : locations) {
-                ::storeLocation(location.toMap());
-            }
+        QLightBoxProgress::setProgressText(tr("Locations import"), QString());
+        for (const QVariant& location : locations) {
+            ::storeLocation(location.toMap(), context);
         }
 
         //
         // Документы
         //
-        {
-            QLightBoxProgress::setProgressText(tr("Documents import"), QString());
-            const QVariantList documents = research["documents"].toList();
-            for (const QVariant& document : documents) {
-                ::storeResearchDocument(document.toMap(), nullptr);
-            }
+        QLightBoxProgress::setProgressText(tr("Documents import"), QString());
+        for (int row = 0; row < documents.size(); ++row) {
+            ::storeResearchDocument(documents.at(row).toMap(), nullptr, row, context);
         }
+
+        DatabaseLayer::Database::commit();
     }
 
     return true;
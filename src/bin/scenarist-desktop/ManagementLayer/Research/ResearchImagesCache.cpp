@@ -0,0 +1,291 @@
+#include "ResearchImagesCache.h"
+
+#include <Domain/Research.h>
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <QtConcurrent>
+
+#include <QtGui/private/qguiapplication_p.h>
+#include <qpa/qplatformintegration.h>
+
+using ManagementLayer::ResearchImagesCache;
+using Domain::Research;
+
+namespace {
+    /**
+     * @brief Максимальный объём памяти, занимаемый пирамидами изображений, Кб
+     * @note Пирамида изображения размером с экран занимает около 10 Мб, так что в кэше
+     *       помещается небольшая галерея вместе с открывавшимися изображениями
+     */
+    const int PYRAMIDS_CACHE_SIZE_KB = 128 * 1024;
+
+    /**
+     * @brief Минимальный размер большей стороны изображения на уровнях пирамиды
+     */
+    const int MINIMUM_LEVEL_SIDE = 128;
+
+    /**
+     * @brief Объём памяти, занимаемый изображением, Кб
+     */
+    static int imageCost(const QPixmap& _image) {
+        return _image.width() * _image.height() * _image.depth() / 8 / 1024;
+    }
+
+    /**
+     * @brief Подготовка уменьшенных копий изображения
+     */
+    struct ImageScaler
+    {
+        typedef QVector<QImage> result_type;
+
+        explicit ImageScaler(const QSize& _maximumSize) :
+            maximumSize(_maximumSize) {}
+
+        QVector<QImage> operator()(const QPixmap& _image) const {
+            return operator()(_image.toImage());
+        }
+
+        QVector<QImage> operator()(const QImage& _image) const {
+            QVector<QImage> levels;
+            if (_image.isNull()) {
+                levels.append(_image);
+                return levels;
+            }
+
+            //
+            // Первый уровень вписываем в максимальный размер...
+            //
+            QImage level = _image;
+            if (level.width() > maximumSize.width()
+                || level.height() > maximumSize.height()) {
+                level = level.scaled(maximumSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+            levels.append(level);
+
+            //
+            // ... а каждый следующий получаем из предыдущего, что дешевле, чем из исходного
+            //
+            while (qMax(level.width(), level.height()) / 2 >= MINIMUM_LEVEL_SIDE) {
+                level = level.scaled(level.size() / 2, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+                levels.append(level);
+            }
+
+            return levels;
+        }
+
+        QSize maximumSize;
+    };
+}
+
+
+ResearchImagesCache::ResearchImagesCache(QObject* _parent) :
+    QObject(_parent),
+    m_pyramids(PYRAMIDS_CACHE_SIZE_KB)
+{
+    connect(&m_preparingWatcher, &QFutureWatcher<QVector<QImage>>::resultReadyAt, this, &ResearchImagesCache::storePreparedImage);
+    connect(&m_preparingWatcher, &QFutureWatcher<QVector<QImage>>::finished, this, &ResearchImagesCache::finishRequest);
+}
+
+ResearchImagesCache::~ResearchImagesCache()
+{
+    cancelRequest();
+}
+
+void ResearchImagesCache::requestGalleryImages(Research* _owner, const QList<Research*>& _images)
+{
+    startRequest(_owner, _images, QSize());
+}
+
+void ResearchImagesCache::requestPreview(Research* _image, const QSize& _size)
+{
+    startRequest(_image, { _image }, _size);
+}
+
+bool ResearchImagesCache::isLoading() const
+{
+    return m_requestOwner != nullptr;
+}
+
+void ResearchImagesCache::remove(Research* _image)
+{
+    m_pyramids.remove(_image);
+
+    //
+    // Изображение, которое готовится прямо сейчас, в кэш уже не попадёт
+    //
+    const int requestIndex = m_requestImages.indexOf(_image);
+    if (requestIndex != -1) {
+        m_requestImages[requestIndex] = nullptr;
+    }
+}
+
+void ResearchImagesCache::clear()
+{
+    cancelRequest();
+    m_pyramids.clear();
+}
+
+QPixmap ResearchImagesCache::pyramidLevel(const ImagePyramid& _pyramid, const QSize& _size)
+{
+    if (_pyramid.isEmpty()) {
+        return QPixmap();
+    }
+
+    if (!_size.isValid()) {
+        return _pyramid.first();
+    }
+
+    //
+    // Уровни идут по убыванию размера, поэтому ищем последний, который ещё покрывает область
+    //
+    int levelIndex = 0;
+    while (levelIndex + 1 < _pyramid.size()) {
+        const QSize nextLevelSize = _pyramid.at(levelIndex + 1).size();
+        if (nextLevelSize.width() < _size.width()
+            && nextLevelSize.height() < _size.height()) {
+            break;
+        }
+        ++levelIndex;
+    }
+    return _pyramid.at(levelIndex);
+}
+
+void ResearchImagesCache::startRequest(Research* _owner, const QList<Research*>& _images,
+    const QSize& _size)
+{
+    cancelRequest();
+
+    m_requestOwner = _owner;
+    m_requestImages = _images;
+    m_requestSize = _size;
+    m_requestPixmaps.fill(QPixmap(), _images.size());
+    m_requestReady.fill(false, _images.size());
+
+    //
+    // Берём из кэша всё, что там есть, а недостающие изображения будем готовить в фоне
+    //
+    QList<QPixmap> missingImages;
+    for (int index = 0; index < _images.size(); ++index) {
+        Research* image = _images.at(index);
+        if (ImagePyramid* pyramid = m_pyramids.object(image)) {
+            m_requestPixmaps[index] = pyramidLevel(*pyramid, _size);
+            m_requestReady[index] = true;
+            continue;
+        }
+
+        m_requestMissingIndexes.append(index);
+        missingImages.append(image->image());
+    }
+
+    deliverReadyImages();
+    if (missingImages.isEmpty()) {
+        finishRequest();
+        return;
+    }
+
+    //
+    // Изображения показываются не крупнее экрана, поэтому хранить их в большем разрешении незачем
+    //
+    QSize maximumSize(1920, 1080);
+    if (QScreen* screen = QGuiApplication::primaryScreen()) {
+        maximumSize = screen->size() * screen->devicePixelRatio();
+    }
+
+    //
+    // Преобразование изображения из QPixmap в QImage тоже затратно, поэтому выполняем его
+    // в фоновых потоках, если платформа позволяет работать там с QPixmap
+    //
+    const ImageScaler scaler(maximumSize);
+    if (QGuiApplicationPrivate::platformIntegration()->hasCapability(QPlatformIntegration::ThreadedPixmaps)) {
+        m_preparingWatcher.setFuture(QtConcurrent::mapped(missingImages, scaler));
+    } else {
+        QList<QImage> missingImagesData;
+        for (const QPixmap& image : missingImages) {
+            missingImagesData.append(image.toImage());
+        }
+        m_preparingWatcher.setFuture(QtConcurrent::mapped(missingImagesData, scaler));
+    }
+}
+
+void ResearchImagesCache::cancelRequest()
+{
+    if (m_preparingWatcher.isRunning()) {
+        m_preparingWatcher.cancel();
+        m_preparingWatcher.waitForFinished();
+    }
+
+    m_requestOwner = nullptr;
+    m_requestImages.clear();
+    m_requestSize = QSize();
+    m_requestPixmaps.clear();
+    m_requestReady.clear();
+    m_requestMissingIndexes.clear();
+    m_requestDeliveredCount = 0;
+}
+
+void ResearchImagesCache::storePreparedImage(int _resultIndex)
+{
+    //
+    // Уведомление о результате отменённого запроса может прийти уже после отмены
+    //
+    if (m_requestOwner == nullptr
+        || _resultIndex >= m_requestMissingIndexes.size()) {
+        return;
+    }
+
+    QList<QPixmap> levels;
+    int cost = 0;
+    for (const QImage& level : m_preparingWatcher.resultAt(_resultIndex)) {
+        levels.append(QPixmap::fromImage(level));
+        cost += imageCost(levels.last());
+    }
+    if (levels.isEmpty()) {
+        return;
+    }
+
+    const int requestIndex = m_requestMissingIndexes.at(_resultIndex);
+    Research* research = m_requestImages.at(requestIndex);
+    const ImagePyramid pyramid = levels.toVector();
+    m_requestPixmaps[requestIndex] = pyramidLevel(pyramid, m_requestSize);
+    if (research != nullptr) {
+        m_pyramids.insert(research, new ImagePyramid(pyramid), qMax(1, cost));
+    }
+    m_requestReady[requestIndex] = true;
+
+    deliverReadyImages();
+}
+
+void ResearchImagesCache::deliverReadyImages()
+{
+    Research* owner = m_requestOwner;
+    while (m_requestOwner == owner
+           && m_requestDeliveredCount < m_requestReady.size()
+           && m_requestReady.at(m_requestDeliveredCount)) {
+        //
+        // Отданное изображение запросу больше не нужно, копия осталась в кэше
+        //
+        const int index = m_requestDeliveredCount++;
+        QPixmap image;
+        m_requestPixmaps[index].swap(image);
+        emit imageReady(owner, index, image);
+    }
+}
+
+void ResearchImagesCache::finishRequest()
+{
+    //
+    // Уведомление об окончании отменённого запроса может прийти уже после отмены
+    //
+    if (m_requestOwner == nullptr) {
+        return;
+    }
+
+    m_requestOwner = nullptr;
+    m_requestImages.clear();
+    m_requestSize = QSize();
+    m_requestPixmaps.clear();
+    m_requestReady.clear();
+    m_requestMissingIndexes.clear();
+    m_requestDeliveredCount = 0;
+}
@@ -0,0 +1,140 @@
+#ifndef RESEARCHIMAGESCACHE_H
+#define RESEARCHIMAGESCACHE_H
+
+#include <QCache>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPixmap>
+#include <QSize>
+#include <QVector>
+
+namespace Domain {
+    class Research;
+}
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Кэш изображений разработки
+     *
+     * Для изображения хранится пирамида уменьшенных копий: первый уровень вписан в размер
+     * экрана, каждый следующий вдвое меньше предыдущего. Галерее отдаётся первый уровень,
+     * т.к. она открывает свои изображения и на весь экран, а предпросмотру - наименьший
+     * уровень, достаточный для отображения в заданном размере.
+     *
+     * Недостающие изображения готовятся в фоновых потоках и отдаются по одному по мере
+     * готовности, в порядке запроса. Занимаемая кэшем память ограничена, давно
+     * не использовавшиеся изображения вытесняются.
+     */
+    class ResearchImagesCache : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ResearchImagesCache(QObject* _parent = nullptr);
+        ~ResearchImagesCache();
+
+        /**
+         * @brief Запросить изображения галереи в размере экрана
+         * @param _owner - галерея, для которой запрашиваются изображения
+         * @note Предыдущий незавершённый запрос отменяется
+         */
+        void requestGalleryImages(Domain::Research* _owner, const QList<Domain::Research*>& _images);
+
+        /**
+         * @brief Запросить открытое изображение для отображения в заданном размере
+         * @note Предыдущий незавершённый запрос отменяется
+         */
+        void requestPreview(Domain::Research* _image, const QSize& _size);
+
+        /**
+         * @brief Выполняется ли сейчас запрос изображений
+         */
+        bool isLoading() const;
+
+        /**
+         * @brief Удалить изображение из кэша, например, после его изменения или удаления
+         */
+        void remove(Domain::Research* _image);
+
+        /**
+         * @brief Очистить кэш
+         */
+        void clear();
+
+    signals:
+        /**
+         * @brief Готово очередное запрошенное изображение
+         * @param _index - номер изображения в запросе, изображения отдаются по порядку
+         */
+        void imageReady(Domain::Research* _owner, int _index, const QPixmap& _image);
+
+    private:
+        /**
+         * @brief Пирамида уменьшенных копий изображения, от наибольшей к наименьшей
+         */
+        typedef QVector<QPixmap> ImagePyramid;
+
+        /**
+         * @brief Наименьший уровень пирамиды, достаточный для отображения в заданном размере
+         * @note Если размер не задан, отдаётся первый уровень, вписанный в размер экрана
+         */
+        static QPixmap pyramidLevel(const ImagePyramid& _pyramid, const QSize& _size);
+
+        /**
+         * @brief Начать запрос: взять из кэша то, что там есть, а недостающее подготовить в фоне
+         */
+        void startRequest(Domain::Research* _owner, const QList<Domain::Research*>& _images,
+            const QSize& _size);
+
+        /**
+         * @brief Отменить выполняющийся запрос
+         */
+        void cancelRequest();
+
+        /**
+         * @brief Сохранить в кэше подготовленное в фоне изображение
+         * @param _resultIndex - номер результата среди недостающих изображений
+         */
+        void storePreparedImage(int _resultIndex);
+
+        /**
+         * @brief Отдать готовые изображения, идущие подряд от последнего отданного
+         */
+        void deliverReadyImages();
+
+        /**
+         * @brief Завершить запрос
+         */
+        void finishRequest();
+
+    private:
+        /**
+         * @brief Пирамиды изображений, стоимость элемента - занимаемая память в килобайтах
+         */
+        QCache<Domain::Research*, ImagePyramid> m_pyramids;
+
+        /**
+         * @brief Наблюдатель за подготовкой недостающих изображений
+         */
+        QFutureWatcher<QVector<QImage>> m_preparingWatcher;
+
+        /**
+         * @brief Параметры выполняющегося запроса
+         */
+        /** @{ */
+        Domain::Research* m_requestOwner = nullptr;
+        QList<Domain::Research*> m_requestImages;
+        QSize m_requestSize;
+        QVector<QPixmap> m_requestPixmaps;
+        QVector<bool> m_requestReady;
+        QVector<int> m_requestMissingIndexes;
+        int m_requestDeliveredCount = 0;
+        /** @} */
+    };
+}
+
+#endif // RESEARCHIMAGESCACHE_H
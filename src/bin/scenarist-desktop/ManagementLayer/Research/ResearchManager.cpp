@@ -1,5 +1,7 @@
 #include "ResearchManager.h"
 
+#include "ResearchImagesCache.h"
+
 #include <DataLayer/DataStorageLayer/ResearchStorage.h>
 #include <DataLayer/DataStorageLayer/ScenarioDataStorage.h>
 #include <DataLayer/DataStorageLayer/ScriptVersionStorage.h>
@@ -25,6 +27,7 @@
 #include <QHBoxLayout>
 #include <QMenu>
 #include <QSplitter>
+#include <QTimer>
 #include <QWidget>
 #include <QWidgetAction>
 
@@ -40,6 +43,33 @@ namespace {
      * @brief Флаг загрузки проекта
      */
     static bool g_isProjectLoading = false;
+
+    /**
+     * @brief Сохранить значение данных сценария с заданным ключом
+     */
+    static void saveScenarioDataValue(const QString& _key, const QString& _value) {
+        if (_key == ScenarioData::NAME_KEY) {
+            StorageFacade::scenarioDataStorage()->setName(_value);
+        } else if (_key == ScenarioData::SCENE_NUMBERS_PREFIX_KEY) {
+            StorageFacade::scenarioDataStorage()->setSceneNumbersPrefix(_value);
+        } else if (_key == ScenarioData::SCENE_START_NUMBER_KEY) {
+            StorageFacade::scenarioDataStorage()->setSceneStartNumber(_value);
+        } else if (_key == ScenarioData::ADDITIONAL_INFO_KEY) {
+            StorageFacade::scenarioDataStorage()->setAdditionalInfo(_value);
+        } else if (_key == ScenarioData::GENRE_KEY) {
+            StorageFacade::scenarioDataStorage()->setGenre(_value);
+        } else if (_key == ScenarioData::AUTHOR_KEY) {
+            StorageFacade::scenarioDataStorage()->setAuthor(_value);
+        } else if (_key == ScenarioData::CONTACTS_KEY) {
+            StorageFacade::scenarioDataStorage()->setContacts(_value);
+        } else if (_key == ScenarioData::YEAR_KEY) {
+            StorageFacade::scenarioDataStorage()->setYear(_value);
+        } else if (_key == ScenarioData::LOGLINE_KEY) {
+            StorageFacade::scenarioDataStorage()->setLogline(_value);
+        } else if (_key == ScenarioData::SYNOPSIS_KEY) {
+            StorageFacade::scenarioDataStorage()->setSynopsis(_value);
+        }
+    }
 }
 
 
@@ -49,7 +79,8 @@ ResearchManager::ResearchManager(QObject* _parent, QWidget* _parentWidget) :
     m_dialog(new ResearchItemDialog(m_view)),
     m_model(new ResearchModel(this)),
     m_currentResearchItem(0),
-    m_currentResearch(0)
+    m_currentResearch(0),
+    m_imagesCache(new ResearchImagesCache(this))
 {
     initView();
     initConnections();
@@ -88,6 +119,13 @@ void ResearchManager::loadCurrentProject()
     m_view->selectItem(m_model->index(0, 0));
     editResearch(m_model->index(0, 0));
 
+    //
+    // Только что загруженные данные совпадают с сохранёнными
+    //
+    m_changedScenarioDataKeys.clear();
+    m_changedResearch.clear();
+    m_isAllResearchChanged = false;
+
     g_isProjectLoading = false;
 }
 
@@ -124,8 +162,13 @@ void ResearchManager::loadCurrentProjectSettings(const QString& _projectPath)
 void ResearchManager::closeCurrentProject()
 {
     m_scenarioData.clear();
+    m_imagesCache->clear();
     m_model->clear();
     m_view->clear();
+
+    m_changedScenarioDataKeys.clear();
+    m_changedResearch.clear();
+    m_isAllResearchChanged = false;
 }
 
 void ResearchManager::saveCurrentProjectSettings(const QString& _projectPath)
@@ -171,29 +214,41 @@ void ResearchManager::updateSettings()
 void ResearchManager::saveResearch()
 {
     //
-    // Сохраняем данные сценария
+    // Сохраняем только те данные сценария, которые изменились
     //
     if (!m_scenarioData.isEmpty()) {
-        StorageFacade::scenarioDataStorage()->setName(m_scenarioData.value(ScenarioData::NAME_KEY));
-        StorageFacade::scenarioDataStorage()->setSceneNumbersPrefix(m_scenarioData.value(ScenarioData::SCENE_NUMBERS_PREFIX_KEY));
-        StorageFacade::scenarioDataStorage()->setSceneStartNumber(m_scenarioData.value(ScenarioData::SCENE_START_NUMBER_KEY));
-        StorageFacade::scenarioDataStorage()->setAdditionalInfo(m_scenarioData.value(ScenarioData::ADDITIONAL_INFO_KEY));
-        StorageFacade::scenarioDataStorage()->setGenre(m_scenarioData.value(ScenarioData::GENRE_KEY));
-        StorageFacade::scenarioDataStorage()->setAuthor(m_scenarioData.value(ScenarioData::AUTHOR_KEY));
-        StorageFacade::scenarioDataStorage()->setContacts(m_scenarioData.value(ScenarioData::CONTACTS_KEY));
-        StorageFacade::scenarioDataStorage()->setYear(m_scenarioData.value(ScenarioData::YEAR_KEY));
-        StorageFacade::scenarioDataStorage()->setLogline(m_scenarioData.value(ScenarioData::LOGLINE_KEY));
-        StorageFacade::scenarioDataStorage()->setSynopsis(m_scenarioData.value(ScenarioData::SYNOPSIS_KEY));
+        foreach (const QString& key, m_changedScenarioDataKeys) {
+            saveScenarioDataValue(key, m_scenarioData.value(key));
+        }
     }
+    m_changedScenarioDataKeys.clear();
 
     //
-    // Сохраняем элементы разработки
+    // Сохраняем только изменившиеся элементы разработки. Журнал сверяем с элементами
+    // хранилища, чтобы не обращаться к уже удалённым элементам
     //
-    foreach (Domain::DomainObject* researchObject,
-             DataStorageLayer::StorageFacade::researchStorage()->all()->toList()) {
-        Domain::Research* research = dynamic_cast<Domain::Research*>(researchObject);
-        DataStorageLayer::StorageFacade::researchStorage()->updateResearch(research);
+    if (m_isAllResearchChanged
+        || !m_changedResearch.isEmpty()) {
+        foreach (Domain::DomainObject* researchObject,
+                 DataStorageLayer::StorageFacade::researchStorage()->all()->toList()) {
+            Domain::Research* research = dynamic_cast<Domain::Research*>(researchObject);
+            if (m_isAllResearchChanged
+                || m_changedResearch.contains(research)) {
+                DataStorageLayer::StorageFacade::researchStorage()->updateResearch(research);
+            }
+        }
+
+        m_changedResearch.clear();
+        m_isAllResearchChanged = false;
+    }
+}
+
+void ResearchManager::markResearchChanged()
+{
+    foreach (const QString& key, m_scenarioData.keys()) {
+        m_changedScenarioDataKeys.insert(key);
     }
+    m_isAllResearchChanged = true;
 }
 
 void ResearchManager::setCommentOnly(bool _isCommentOnly)
@@ -447,20 +502,19 @@ void ResearchManager::editResearch(const QModelIndex& _index)
 
                 case Research::ImagesGallery: {
                     //
-                    // Формируем список изображений от вложенных элементов
+                    // Показываем пустую галерею, а вложенные изображения добавим по мере того,
+                    // как они будут подготовлены кэшем
                     //
-                    QList<QPixmap> images;
-                    if (researchItem->hasChildren()) {
-                        for (int childIndex = 0; childIndex < researchItem->childCount(); ++childIndex) {
-                            images.append(researchItem->childAt(childIndex)->research()->image());
-                        }
-                    }
-                    m_view->editImagesGallery(research->name(), images);
+                    requestGalleryImages(researchItem);
                     break;
                 }
 
                 case Research::Image: {
-                    m_view->editImage(research->name(), research->image());
+                    //
+                    // Изображение нужного для предпросмотра размера покажем, когда его подготовит кэш
+                    //
+                    m_view->editImage(research->name(), QPixmap());
+                    requestPreviewImage(research);
                     break;
                 }
 
@@ -517,8 +571,9 @@ void ResearchManager::removeResearchItem(BusinessLogic::ResearchModelItem* _item
     m_view->selectItem(itemForSelect);
 
     //
-    // Удалим
+    // Удалим, сбросив кэш изображений, ведь вместе с элементом удаляются и все вложенные
     //
+    m_imagesCache->clear();
     DataStorageLayer::StorageFacade::researchStorage()->removeResearch(_item->research());
 }
 
@@ -626,9 +681,13 @@ void ResearchManager::showNavigatorContextMenu(const QModelIndex& _index, const
             refreshResearchSubtree(_index);
         } else if (toggledAction == removeColorAction) {
             researchItem->research()->setColor(QColor());
+            markResearchChanged(researchItem->research());
+            emit researchChanged();
         } else {
             if (colorsPane->currentColor().isValid()) {
                 researchItem->research()->setColor(colorsPane->currentColor());
+                markResearchChanged(researchItem->research());
+                emit researchChanged();
             }
         }
     }
@@ -643,10 +702,52 @@ void ResearchManager::updateScenarioData(const QString& _key, const QString& _va
         && m_scenarioData.contains(_key)
         && m_scenarioData.value(_key) != _value) {
         m_scenarioData.insert(_key, _value);
+        m_changedScenarioDataKeys.insert(_key);
         emit researchChanged();
     }
 }
 
+void ResearchManager::requestGalleryImages(BusinessLogic::ResearchModelItem* _galleryItem)
+{
+    m_view->blockSignals(true);
+    m_view->editImagesGallery(_galleryItem->research()->name(), QList<QPixmap>());
+    m_view->blockSignals(false);
+
+    QList<Research*> images;
+    for (int childIndex = 0; childIndex < _galleryItem->childCount(); ++childIndex) {
+        images.append(_galleryItem->childAt(childIndex)->research());
+    }
+    m_imagesCache->requestGalleryImages(_galleryItem->research(), images);
+}
+
+void ResearchManager::requestPreviewImage(Domain::Research* _image)
+{
+    m_imagesCache->requestPreview(_image, m_view->imagePreviewSize());
+}
+
+void ResearchManager::markResearchChanged(Domain::Research* _research)
+{
+    if (_research != nullptr) {
+        m_changedResearch.insert(_research);
+    }
+}
+
+void ResearchManager::markResearchChildrenChanged(const QModelIndex& _parent)
+{
+    //
+    // При вставке, удалении и перемещении строк меняется порядок сортировки всех соседей
+    //
+    ResearchModelItem* parentItem = m_model->itemForIndex(_parent);
+    if (parentItem == nullptr) {
+        return;
+    }
+
+    markResearchChanged(parentItem->research());
+    for (int row = 0; row < parentItem->childCount(); ++row) {
+        markResearchChanged(parentItem->childAt(row)->research());
+    }
+}
+
 void ResearchManager::initView()
 {
     m_view->setResearchModel(m_model);
@@ -654,6 +755,55 @@ void ResearchManager::initView()
 
 void ResearchManager::initConnections()
 {
+    //
+    // Любое изменение разработки, в том числе пришедшее извне (синхронизация, импорт),
+    // требует её сохранения
+    //
+    // NOTE: Изменения, сделанные в редакторе, относятся к текущему элементу, а изменения
+    //       остальных элементов помечаются непосредственно там, где они происходят
+    //
+    connect(this, &ResearchManager::researchChanged, this, [this] {
+        markResearchChanged(m_currentResearch);
+    });
+    connect(m_model, &ResearchModel::dataChanged, this,
+            [this] (const QModelIndex& _topLeft, const QModelIndex& _bottomRight) {
+        for (int row = _topLeft.row(); row <= _bottomRight.row(); ++row) {
+            const QModelIndex index = m_model->index(row, 0, _topLeft.parent());
+            if (ResearchModelItem* item = m_model->itemForIndex(index)) {
+                markResearchChanged(item->research());
+            }
+        }
+    });
+    connect(m_model, &ResearchModel::rowsInserted, this, [this] (const QModelIndex& _parent) {
+        markResearchChildrenChanged(_parent);
+    });
+    connect(m_model, &ResearchModel::rowsRemoved, this, [this] (const QModelIndex& _parent) {
+        markResearchChildrenChanged(_parent);
+    });
+    connect(m_model, &ResearchModel::rowsMoved, this,
+            [this] (const QModelIndex& _sourceParent, int, int, const QModelIndex& _destinationParent) {
+        markResearchChildrenChanged(_sourceParent);
+        markResearchChildrenChanged(_destinationParent);
+    });
+
+    connect(m_imagesCache, &ResearchImagesCache::imageReady, this,
+            [this] (Research* _owner, int, const QPixmap& _image) {
+        //
+        // Пока изображения готовились, пользователь мог перейти к другому элементу
+        //
+        if (m_currentResearch != _owner) {
+            return;
+        }
+
+        m_view->blockSignals(true);
+        if (_owner->type() == Research::ImagesGallery) {
+            m_view->addImagesGalleryImage(_image);
+        } else if (_owner->type() == Research::Image) {
+            m_view->editImage(_owner->name(), _image);
+        }
+        m_view->blockSignals(false);
+    });
+
     connect(m_model, &ResearchModel::itemMoved, this, [this] (const QModelIndex& _index) {
         m_view->selectItem(_index);
         emit researchChanged();
@@ -728,6 +878,7 @@ void ResearchManager::initConnections()
             if (StorageFacade::researchStorage()->hasCharacter(_name)) {
                 Research* mainCharacter = StorageFacade::researchStorage()->character(_name);
                 mainCharacter->addDescription(m_currentResearch->description());
+                markResearchChanged(mainCharacter);
                 removeResearchItem(m_currentResearchItem);
             }
             //
@@ -772,6 +923,7 @@ void ResearchManager::initConnections()
             if (StorageFacade::researchStorage()->hasLocation(_name)) {
                 Research* mainLocation = StorageFacade::researchStorage()->location(_name);
                 mainLocation->addDescription(m_currentResearch->description());
+                markResearchChanged(mainLocation);
                 removeResearchItem(m_currentResearchItem);
             }
             //
@@ -866,6 +1018,21 @@ void ResearchManager::initConnections()
                 StorageFacade::researchStorage()->storeResearch(
                     m_currentResearch, Research::Image, _sortOrder, tr("Unnamed image"));
             newResearch->setImage(_image);
+            markResearchChanged(newResearch);
+
+            //
+            // Если изображения галереи ещё готовятся, то добавленное пользователем изображение
+            // оказалось в галерее раньше ещё не подготовленных, поэтому перезапросим галерею
+            // целиком. Делаем это после того, как галерея закончит обработку добавления
+            //
+            if (m_imagesCache->isLoading()) {
+                ResearchModelItem* galleryItem = m_currentResearchItem;
+                QTimer::singleShot(0, this, [this, galleryItem] {
+                    if (m_currentResearchItem == galleryItem) {
+                        requestGalleryImages(galleryItem);
+                    }
+                });
+            }
 
             emit researchChanged();
         }
@@ -881,6 +1048,7 @@ void ResearchManager::initConnections()
             //
             // ... удалим
             //
+            m_imagesCache->remove(researchToDelete);
             DataStorageLayer::StorageFacade::researchStorage()->removeResearch(researchToDelete);
 
             //
@@ -889,7 +1057,10 @@ void ResearchManager::initConnections()
             for (int childIndex = _sortOrder; childIndex < m_currentResearchItem->childCount(); ++childIndex) {
                 Research* research = m_currentResearchItem->childAt(childIndex)->research();
                 research->setSortOrder(research->sortOrder() - 1);
+                markResearchChanged(research);
             }
+
+            emit researchChanged();
         }
     });
     //
@@ -908,6 +1079,10 @@ void ResearchManager::initConnections()
         if (m_currentResearch != nullptr
             && m_currentResearch->type() == Research::Image) {
             m_currentResearch->setImage(_image);
+            m_imagesCache->remove(m_currentResearch);
+            if (m_imagesCache->isLoading()) {
+                requestPreviewImage(m_currentResearch);
+            }
             emit researchChanged();
         }
     });
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSet>
 
 class QAbstractItemModel;
 
@@ -23,6 +24,8 @@ namespace BusinessLogic {
 
 namespace ManagementLayer
 {
+    class ResearchImagesCache;
+
     /**
      * @brief Управляющий разработкой
      */
@@ -78,6 +81,12 @@ namespace ManagementLayer
          */
         void saveResearch();
 
+        /**
+         * @brief Пометить разработку и данные сценария как изменённые
+         * @note Используется, когда сохранение не удалось и при следующей попытке нужно записать всё заново
+         */
+        void markResearchChanged();
+
         /**
          * @brief Установить режим работы со сценарием
          */
@@ -193,6 +202,24 @@ namespace ManagementLayer
          */
         void updateScenarioData(const QString& _key, const QString& _value);
 
+        /**
+         * @brief Показать пустую галерею и запросить у кэша миниатюры её изображений
+         */
+        void requestGalleryImages(BusinessLogic::ResearchModelItem* _galleryItem);
+
+        /**
+         * @brief Запросить у кэша изображение для предпросмотра
+         */
+        void requestPreviewImage(Domain::Research* _image);
+
+        /**
+         * @brief Пометить элементы разработки как изменённые
+         */
+        /** @{ */
+        void markResearchChanged(Domain::Research* _research);
+        void markResearchChildrenChanged(const QModelIndex& _parent);
+        /** @} */
+
     private:
         /**
          * @brief Настроить представление
@@ -230,6 +257,28 @@ namespace ManagementLayer
          */
         BusinessLogic::ResearchModelItem* m_currentResearchItem;
         Domain::Research* m_currentResearch;
+
+        /**
+         * @brief Кэш изображений галерей
+         */
+        ResearchImagesCache* m_imagesCache;
+
+        /**
+         * @brief Ключи данных сценария, изменившихся с момента последнего сохранения
+         */
+        QSet<QString> m_changedScenarioDataKeys;
+
+        /**
+         * @brief Элементы разработки, изменившиеся с момента последнего сохранения
+         * @note Элементы только сравниваются с хранящимися в хранилище, поэтому в журнале
+         *       могут оставаться указатели на уже удалённые элементы
+         */
+        QSet<Domain::Research*> m_changedResearch;
+
+        /**
+         * @brief Нужно ли сохранить все элементы разработки, независимо от журнала изменений
+         */
+        bool m_isAllResearchChanged = false;
     };
 }
 
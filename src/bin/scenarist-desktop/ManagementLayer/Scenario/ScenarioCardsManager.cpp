@@ -17,10 +17,16 @@
 #include <3rd_party/Helpers/TextUtils.h>
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QPainter>
 #include <QPrinter>
 #include <QPrintPreviewDialog>
 #include <QScopedPointer>
+#include <QSet>
+#include <QTimer>
+#include <QXmlStreamReader>
+#include <QtConcurrent>
 
 using ManagementLayer::ScenarioCardsManager;
 using UserInterface::PrintCardsDialog;
@@ -29,6 +35,106 @@ using UserInterface::ScenarioItemDialog;
 
 namespace {
     const bool IS_SCRIPT = false;
+
+    /**
+     * @brief Заголовок карточки для элемента сценария
+     */
+    static QString cardTitle(const BusinessLogic::ScenarioModelItem* _item) {
+        return TextEditHelper::smartToUpper(_item->name().isEmpty() ? _item->header() : _item->name());
+    }
+
+    /**
+     * @brief Текст карточки для элемента сценария
+     */
+    static QString cardDescription(const BusinessLogic::ScenarioModelItem* _item) {
+        return _item->description().isEmpty() ? _item->fullText() : _item->description();
+    }
+
+    /**
+     * @brief Есть ли у элемента сценария карточка
+     * @note Карточки не строятся для элементов неопределённого типа и для сцен, уровень
+     *       вложенности которых больше второго
+     */
+    static bool hasCard(const BusinessLogic::ScenarioModelItem* _item) {
+        return _item->type() != BusinessLogic::ScenarioModelItem::Undefined
+                && !(_item->hasParent()
+                     && _item->parent()->hasParent()
+                     && _item->parent()->parent()->hasParent());
+    }
+
+    /**
+     * @brief Идентификаторы карточек схемы в порядке их следования
+     */
+    static QStringList schemeCardsUuids(const QString& _xml) {
+        QStringList uuids;
+        QXmlStreamReader reader(_xml);
+        while (!reader.atEnd()) {
+            if (reader.readNext() == QXmlStreamReader::StartElement
+                && reader.attributes().hasAttribute("uuid")) {
+                uuids.append(reader.attributes().value("uuid").toString());
+            }
+        }
+        return uuids;
+    }
+
+    /**
+     * @brief Интервал обновления прогресса печати, мс
+     */
+    const int PROGRESS_UPDATE_INTERVAL = 100;
+
+    /**
+     * @brief Нарисовать линии разреза страницы с заданным количеством карточек
+     */
+    static void drawCutLines(QPainter& _painter, const QRectF& _pageRect, int _cardsCount) {
+        switch (_cardsCount) {
+            default:
+            case 1: {
+                //
+                // Нет линий разреза
+                //
+                break;
+            }
+
+            case 2: {
+                //
+                // Горизонтальная линия
+                //
+                const qreal height = _pageRect.height() / 2.;
+                QPointF p1 = _pageRect.topLeft() + QPointF(0, height);
+                QPointF p2 = _pageRect.topRight() + QPointF(0, height);
+                _painter.drawLine(p1, p2);
+                break;
+            }
+
+            case 4:
+            case 6:
+            case 8: {
+                //
+                // Горизонтальные линии
+                //
+                {
+                    const qreal height = _pageRect.height() / (_cardsCount / 2.);
+                    qreal summaryHeight = 0;
+                    while (summaryHeight + height < _pageRect.height()) {
+                        summaryHeight += height;
+                        const QPointF p1 = _pageRect.topLeft() + QPointF(0, summaryHeight);
+                        const QPointF p2 = _pageRect.topRight() + QPointF(0, summaryHeight);
+                        _painter.drawLine(p1, p2);
+                    }
+                }
+                //
+                // Вертикальная линия
+                //
+                {
+                    const qreal width = _pageRect.width() / 2.;
+                    const QPointF p1 = _pageRect.topLeft() + QPointF(width, 0);
+                    const QPointF p2 = _pageRect.bottomLeft() + QPointF(width, 0);
+                    _painter.drawLine(p1, p2);
+                }
+                break;
+            }
+        }
+    }
 }
 
 
@@ -71,18 +177,25 @@ void ScenarioCardsManager::reloadSettings()
                 );
 }
 
-QString ScenarioCardsManager::save() const
+QString ScenarioCardsManager::save()
 {
+    applyCardChanges();
     return m_view->save();
 }
 
 void ScenarioCardsManager::saveChanges(bool _hasChangesInText)
 {
+    applyCardChanges();
     m_view->saveChanges(_hasChangesInText);
 }
 
 void ScenarioCardsManager::load(BusinessLogic::ScenarioModel* _model, const QString& _xml)
 {
+    //
+    // Изменения предыдущей модели к загружаемой схеме отношения не имеют
+    //
+    m_cardChanges.clear();
+
     //
     // Сохраним модель
     //
@@ -90,21 +203,12 @@ void ScenarioCardsManager::load(BusinessLogic::ScenarioModel* _model, const QStr
         m_model = _model;
         connect(m_model, &BusinessLogic::ScenarioModel::rowsInserted, this, [this] (const QModelIndex& _parent, int _first, int _last) {
             //
-            // Пробегаем каждый добавленный элемент
+            // Запоминаем каждый добавленный элемент
             //
             for (int row = _first; row <= _last; ++row) {
                 const QModelIndex index = m_model->index(row, 0, _parent);
                 BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(index);
 
-                //
-                // ... пропускаем сцены если их уровень вложенности больше второго
-                //
-                if (item->hasParent()
-                    && item->parent()->hasParent()
-                    && item->parent()->parent()->hasParent()) {
-                    continue;
-                }
-
                 //
                 // ... определим предыдущий элемент
                 //
@@ -122,22 +226,7 @@ void ScenarioCardsManager::load(BusinessLogic::ScenarioModel* _model, const QStr
                 }
                 BusinessLogic::ScenarioModelItem* currentCard = m_model->itemForIndex(currentCardIndex);
 
-                //
-                // ... вставляем
-                //
-                const bool isEmbedded =
-                        item->hasParent()
-                        && item->parent()->type() != BusinessLogic::ScenarioModelItem::Scenario;
-                m_view->insertCard(
-                    item->uuid(),
-                    item->type() == BusinessLogic::ScenarioModelItem::Folder,
-                    item->sceneNumber(),
-                    item->name().isEmpty() ? TextEditHelper::smartToUpper(item->header()) : TextEditHelper::smartToUpper(item->name()),
-                    item->description().isEmpty() ? item->fullText() : item->description(),
-                    item->stamp(),
-                    item->colors(),
-                    isEmbedded,
-                    currentCard->uuid());
+                addCardChange(CardChange::Insert, index, item->uuid(), currentCard->uuid());
             }
         });
         connect(m_model, &BusinessLogic::ScenarioModel::rowsAboutToBeRemoved, this, [this] (const QModelIndex& _parent, int _first, int _last) {
@@ -149,41 +238,14 @@ void ScenarioCardsManager::load(BusinessLogic::ScenarioModel* _model, const QStr
                     currentCardIndex = m_model->index(row, 0);
                 }
                 BusinessLogic::ScenarioModelItem* currentCard = m_model->itemForIndex(currentCardIndex);
-                m_view->removeCard(currentCard->uuid());
+                addCardChange(CardChange::Remove, currentCardIndex, currentCard->uuid());
             }
         });
         connect(m_model, &BusinessLogic::ScenarioModel::dataChanged, this, [this] (const QModelIndex& _topLeft, const QModelIndex& _bottomRight) {
             for (int row = _topLeft.row(); row <= _bottomRight.row(); ++row) {
                 const QModelIndex index = m_model->index(row, 0, _topLeft.parent());
                 const BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(index);
-                //
-                // Если тип карточки определить не удалось, удаляем её
-                //
-                if (item->type() == BusinessLogic::ScenarioModelItem::Undefined) {
-                    m_view->removeCard(item->uuid());
-                }
-                //
-                // А если тип нормальный, то обновляем данные о карточке
-                //
-                else {
-                    const bool isAct =
-                            item->type() == BusinessLogic::ScenarioModelItem::Folder
-                            && item->hasParent()
-                            && item->parent()->type() == BusinessLogic::ScenarioModelItem::Scenario;
-                    const bool isEmbedded =
-                            item->hasParent()
-                            && item->parent()->type() != BusinessLogic::ScenarioModelItem::Scenario;
-                    m_view->updateCard(
-                        item->uuid(),
-                        item->type() == BusinessLogic::ScenarioModelItem::Folder,
-                        item->sceneNumber(),
-                        item->name().isEmpty() ? TextEditHelper::smartToUpper(item->header()) : TextEditHelper::smartToUpper(item->name()),
-                        item->description().isEmpty() ? item->fullText() : item->description(),
-                        item->stamp(),
-                        item->colors(),
-                        isEmbedded,
-                        isAct);
-                }
+                addCardChange(CardChange::Update, index, item->uuid());
             }
         });
     }
@@ -202,6 +264,109 @@ void ScenarioCardsManager::load(BusinessLogic::ScenarioModel* _model, const QStr
     else {
         m_view->load(m_model->simpleScheme());
     }
+
+}
+
+void ScenarioCardsManager::syncWithModel()
+{
+    if (m_model == nullptr) {
+        return;
+    }
+
+    //
+    // Сначала применяем изменения модели, которые уже пришли к карточкам
+    //
+    applyCardChanges();
+
+    //
+    // Определим карточки, которые есть в схеме...
+    //
+    const QStringList schemeUuids = ::schemeCardsUuids(m_view->save());
+    const QSet<QString> schemeUuidsSet = QSet<QString>::fromList(schemeUuids);
+
+    //
+    // ... и элементы модели, у которых должны быть карточки, в порядке их следования
+    //
+    QVector<QModelIndex> modelIndexes;
+    QStringList modelUuids;
+    QVector<QModelIndex> parents { QModelIndex() };
+    while (!parents.isEmpty()) {
+        const QModelIndex parent = parents.takeLast();
+        if (parent.isValid()) {
+            const BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(parent);
+            if (!::hasCard(item)) {
+                continue;
+            }
+            modelIndexes.append(parent);
+            modelUuids.append(item->uuid());
+        }
+        for (int row = m_model->rowCount(parent) - 1; row >= 0; --row) {
+            parents.append(m_model->index(row, 0, parent));
+        }
+    }
+    const QSet<QString> modelUuidsSet = QSet<QString>::fromList(modelUuids);
+
+    //
+    // Представление не обещает формат своей схемы, поэтому если карточек в ней не нашлось,
+    // а в модели элементы для них есть, то не полагаемся на разбор схемы и строим её заново
+    //
+    if (schemeUuids.isEmpty() && !modelUuids.isEmpty()) {
+        m_view->load(m_model->simpleScheme());
+        return;
+    }
+
+    //
+    // Если общие для схемы и модели карточки идут в разном порядке, то сцены были перемещены,
+    // а расположение карточек после перемещения проще построить заново
+    //
+    QStringList schemeCommonUuids;
+    for (const QString& uuid : schemeUuids) {
+        if (modelUuidsSet.contains(uuid)) {
+            schemeCommonUuids.append(uuid);
+        }
+    }
+    QStringList modelCommonUuids;
+    for (const QString& uuid : modelUuids) {
+        if (schemeUuidsSet.contains(uuid)) {
+            modelCommonUuids.append(uuid);
+        }
+    }
+    if (schemeCommonUuids != modelCommonUuids) {
+        m_view->load(m_model->simpleScheme());
+        return;
+    }
+
+    //
+    // В остальных случаях удаляем лишние карточки и добавляем недостающие,
+    // не трогая тех, что совпадают
+    //
+    if (schemeUuidsSet == modelUuidsSet) {
+        return;
+    }
+
+    const bool updatesEnabled = m_view->updatesEnabled();
+    m_view->setUpdatesEnabled(false);
+    for (const QString& uuid : schemeUuids) {
+        if (!modelUuidsSet.contains(uuid)) {
+            m_view->removeCard(uuid);
+        }
+    }
+    for (const QModelIndex& index : modelIndexes) {
+        const BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(index);
+        if (schemeUuidsSet.contains(item->uuid())) {
+            continue;
+        }
+
+        //
+        // ... вставляем после предыдущего элемента того же уровня, а первый - после родителя
+        //
+        QModelIndex previousIndex = index.parent();
+        if (index.row() > 0) {
+            previousIndex = m_model->index(index.row() - 1, 0, index.parent());
+        }
+        insertCard(item, m_model->itemForIndex(previousIndex)->uuid());
+    }
+    m_view->setUpdatesEnabled(updatesEnabled);
 }
 
 void ScenarioCardsManager::clear()
@@ -210,16 +375,19 @@ void ScenarioCardsManager::clear()
         m_model->disconnect(this);
         m_model = nullptr;
     }
+    m_cardChanges.clear();
     m_view->clear();
 }
 
 void ScenarioCardsManager::undo()
 {
+    applyCardChanges();
     m_view->undo();
 }
 
 void ScenarioCardsManager::redo()
 {
+    applyCardChanges();
     m_view->redo();
 }
 
@@ -228,6 +396,165 @@ void ScenarioCardsManager::setCommentOnly(bool _isCommentOnly)
     m_view->setCommentOnly(_isCommentOnly);
 }
 
+void ScenarioCardsManager::insertCard(const BusinessLogic::ScenarioModelItem* _item, const QString& _previousCardUuid)
+{
+    const bool isEmbedded =
+            _item->hasParent()
+            && _item->parent()->type() != BusinessLogic::ScenarioModelItem::Scenario;
+    m_view->insertCard(
+        _item->uuid(),
+        _item->type() == BusinessLogic::ScenarioModelItem::Folder,
+        _item->sceneNumber(),
+        cardTitle(_item),
+        cardDescription(_item),
+        _item->stamp(),
+        _item->colors(),
+        isEmbedded,
+        _previousCardUuid);
+}
+
+void ScenarioCardsManager::addCardChange(CardChange::Type _type, const QModelIndex& _index,
+    const QString& _uuid, const QString& _previousCardUuid)
+{
+    //
+    // Изменения применяются к представлению разом, после того, как модель закончит обновляться
+    //
+    if (m_cardChanges.isEmpty()) {
+        QTimer::singleShot(0, this, &ScenarioCardsManager::applyCardChanges);
+    }
+
+    CardChange change;
+    change.type = _type;
+    change.index = _index;
+    change.uuid = _uuid;
+    change.previousCardUuid = _previousCardUuid;
+    m_cardChanges.append(change);
+}
+
+void ScenarioCardsManager::applyCardChanges()
+{
+    if (m_cardChanges.isEmpty()
+        || m_model == nullptr) {
+        m_cardChanges.clear();
+        return;
+    }
+
+    //
+    // Определим, какие изменения можно не применять:
+    // - обновления карточек, которые обновляются в этой же пачке ещё раз, или добавляются в ней,
+    //   т.к. данные элемента в любом случае берутся актуальные на момент применения
+    //   (но если элемент стал неопределённого типа, то добавленную карточку нужно удалить)
+    //
+    QSet<QString> insertedUuids;
+    QHash<QString, int> lastUpdates;
+    for (int changeIndex = 0; changeIndex < m_cardChanges.size(); ++changeIndex) {
+        const CardChange& change = m_cardChanges.at(changeIndex);
+        if (change.type == CardChange::Insert) {
+            insertedUuids.insert(change.uuid);
+        } else if (change.type == CardChange::Update) {
+            lastUpdates.insert(change.uuid, changeIndex);
+        }
+    }
+
+    //
+    // Применяем изменения в том порядке, в котором они происходили в модели,
+    // перерисовывая представление единожды в конце
+    //
+    const bool updatesEnabled = m_view->updatesEnabled();
+    m_view->setUpdatesEnabled(false);
+    //
+    // ... для не вставленных карточек запоминаем, после какой карточки они должны были стоять,
+    //     чтобы вставлять следующие за ними карточки после ближайшей вставленной
+    //
+    QHash<QString, QString> skippedCardsAnchors;
+    for (int changeIndex = 0; changeIndex < m_cardChanges.size(); ++changeIndex) {
+        const CardChange& change = m_cardChanges.at(changeIndex);
+        switch (change.type) {
+            case CardChange::Insert: {
+                //
+                // Элемент мог быть удалён из модели ещё до применения изменений
+                //
+                const QString previousCardUuid =
+                        skippedCardsAnchors.value(change.previousCardUuid, change.previousCardUuid);
+                if (!change.index.isValid()) {
+                    skippedCardsAnchors.insert(change.uuid, previousCardUuid);
+                    break;
+                }
+                BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(change.index);
+
+                //
+                // ... пропускаем сцены если их уровень вложенности больше второго
+                //
+                if (item->hasParent()
+                    && item->parent()->hasParent()
+                    && item->parent()->parent()->hasParent()) {
+                    break;
+                }
+
+                //
+                // ... вставляем
+                //
+                insertCard(item, previousCardUuid);
+                break;
+            }
+
+            case CardChange::Update: {
+                if (lastUpdates.value(change.uuid) != changeIndex
+                    || !change.index.isValid()) {
+                    break;
+                }
+                const BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(change.index);
+
+                //
+                // Если тип карточки определить не удалось, удаляем её, даже если она
+                // была добавлена в этой же пачке
+                //
+                if (item->type() == BusinessLogic::ScenarioModelItem::Undefined) {
+                    m_view->removeCard(item->uuid());
+                }
+                //
+                // А если тип нормальный, то обновляем данные о карточке, если она
+                // не была добавлена с актуальными данными в этой же пачке
+                //
+                else if (!insertedUuids.contains(change.uuid)) {
+                    const bool isAct =
+                            item->type() == BusinessLogic::ScenarioModelItem::Folder
+                            && item->hasParent()
+                            && item->parent()->type() == BusinessLogic::ScenarioModelItem::Scenario;
+                    const bool isEmbedded =
+                            item->hasParent()
+                            && item->parent()->type() != BusinessLogic::ScenarioModelItem::Scenario;
+                    m_view->updateCard(
+                        item->uuid(),
+                        item->type() == BusinessLogic::ScenarioModelItem::Folder,
+                        item->sceneNumber(),
+                        cardTitle(item),
+                        cardDescription(item),
+                        item->stamp(),
+                        item->colors(),
+                        isEmbedded,
+                        isAct);
+                }
+                break;
+            }
+
+            case CardChange::Remove: {
+                //
+                // Не вставленную карточку и удалять не нужно
+                //
+                if (skippedCardsAnchors.contains(change.uuid)) {
+                    break;
+                }
+
+                m_view->removeCard(change.uuid);
+                break;
+            }
+        }
+    }
+    m_cardChanges.clear();
+    m_view->setUpdatesEnabled(updatesEnabled);
+}
+
 void ScenarioCardsManager::goToCard(const QString& _uuid)
 {
     const QModelIndex indexForUpdate = m_model->indexForUuid(_uuid);
@@ -401,11 +728,17 @@ void ScenarioCardsManager::print()
     //
     // Запускаем предпросмотр
     //
+    // NOTE: Раскладка карточек формируется заново для каждого сеанса печати, т.к. сценарий
+    //       мог измениться, а в рамках сеанса переиспользуется предпросмотром и печатью
+    //
+    m_printLayoutKey.clear();
     printDialog.exec();
 
     //
     // Очищаем память
     //
+    m_printLayoutKey.clear();
+    m_printedCards.clear();
     delete printer;
 }
 
@@ -418,257 +751,223 @@ void ScenarioCardsManager::printCards(QPrinter* _printer)
     m_printDialog->setProgressValue(0);
     m_printDialog->showProgress(0, 0);
 
-    //
-    // Подготовим список карточек для печати
-    //
-    QMap<int, BusinessLogic::ScenarioModelItem*> items;
-    {
-        QVector<QModelIndex> parents { QModelIndex() };
-        do {
-            const int parentsSize = parents.size();
-            for (int parentIndexRow = parentsSize - 1; parentIndexRow >= 0; --parentIndexRow) {
-                //
-                // Обновляем значение прогресса
-                //
-                QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-
-                //
-                // Собираем элементы
-                //
-                const QModelIndex& parentIndex = parents.at(parentIndexRow);
-                for (int row = 0; row < m_model->rowCount(parentIndex); ++row) {
-                    const QModelIndex index = m_model->index(row, 0, parentIndex);
-                    parents.append(index);
-
-                    auto item = m_model->itemForIndex(index);
-                    items.insert(item->position(), item);
-                }
-                parents.remove(parentIndexRow);
-            }
-        } while (!parents.isEmpty());
-    }
+    QPainter painter(_printer);
+    QFont titleFont = painter.font();
+    titleFont.setBold(true);
+    QFont descriptionFont = painter.font();
+    descriptionFont.setBold(false);
 
-    //
-    // Покажем прогресс
-    //
-    int progress = 0;
-    m_printDialog->setProgressValue(progress);
-    m_printDialog->showProgress(0, items.size());
+    const int cardsCount = m_printDialog->cardsCount();
+    const qreal sideMargin = _printer->pageRect().x();
+    const QRectF pageRect = _printer->paperRect().adjusted(0, 0, -2 * sideMargin, -2 * sideMargin);
+    painter.setFont(titleFont);
+    const int titleHeight = painter.fontMetrics().height();
 
     //
-    // Печатаем карточки
+    // Раскладку карточек формируем только если она ещё не была сформирована для таких же параметров,
+    // например, при повторной отрисовке предпросмотра, или при печати из него
     //
-    QPainter painter(_printer);
+    const QString printLayoutKey =
+            QString("%1;%2;%3;%4;%5").arg(cardsCount).arg(sideMargin).arg(pageRect.width())
+            .arg(pageRect.height()).arg(painter.font().toString());
+    if (m_printLayoutKey != printLayoutKey) {
+        m_printLayoutKey = printLayoutKey;
+        m_printedCards.clear();
 
-    //
-    // Проходим все карточки по-очереди
-    //
-    bool isFirst = true;
-    const int firstCardIndex = 0;
-    const int cardsCount = m_printDialog->cardsCount();
-    const qreal sideMargin = _printer->pageRect().x();
-    int currentCardIndex = firstCardIndex;
-    qreal lastY = 0;
-    for (const int& key : items.keys()) {
         //
-        // Обновляем значение прогресса
+        // Подготовим список карточек для печати, обходя модель в порядке следования элементов
         //
-        m_printDialog->setProgressValue(++progress);
-        QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+        QVector<QModelIndex> indexes { QModelIndex() };
+        while (!indexes.isEmpty()) {
+            const QModelIndex parentIndex = indexes.takeLast();
+            for (int row = m_model->rowCount(parentIndex) - 1; row >= 0; --row) {
+                indexes.append(m_model->index(row, 0, parentIndex));
+            }
+            if (!parentIndex.isValid()) {
+                continue;
+            }
 
-        const BusinessLogic::ScenarioModelItem* item = items[key];
-        const QRectF pageRect = _printer->paperRect().adjusted(0, 0, -2 * sideMargin, -2 * sideMargin);
+            const BusinessLogic::ScenarioModelItem* item = m_model->itemForIndex(parentIndex);
+            PrintedCard card;
+            card.title = item->name().isEmpty() ? item->header() : item->name();
+            if (item->type() == BusinessLogic::ScenarioModelItem::Scene) {
+                card.title.prepend(QString("%1. ").arg(item->sceneNumber()));
+            }
+            card.title = TextEditHelper::smartToUpper(card.title);
+            card.description = cardDescription(item);
+            card.description.replace("\n", "\n\n");
+            m_printedCards.append(card);
+        }
 
         //
-        // Если надо, переходим на новую страницу и рисуем линии разреза
+        // Определяем области карточек на страницах
         //
-        if (currentCardIndex == firstCardIndex) {
-            if (isFirst) {
-                isFirst = false;
-            } else {
-                _printer->newPage();
-            }
+        int currentCardIndex = 0;
+        qreal lastY = 0;
+        for (PrintedCard& card : m_printedCards) {
+            card.isPageStart = currentCardIndex == 0;
 
-            painter.setClipRect(pageRect);
-            painter.save();
-            painter.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+            QRectF cardRect = pageRect;
+            cardRect.moveTop(cardRect.top() + lastY);
             switch (cardsCount) {
                 default:
                 case 1: {
                     //
-                    // Нет линий разреза
+                    // Вся страница
                     //
                     break;
                 }
 
                 case 2: {
-                    //
-                    // Горизонтальная линия
-                    //
-                    const qreal height = pageRect.height() / 2.;
-                    QPointF p1 = pageRect.topLeft() + QPointF(0, height);
-                    QPointF p2 = pageRect.topRight() + QPointF(0, height);
-                    painter.drawLine(p1, p2);
+                    const qreal height = cardRect.height() / 2.;
+                    cardRect.setHeight(height);
+                    lastY += height;
                     break;
                 }
 
                 case 4:
                 case 6:
                 case 8: {
+                    const qreal width = cardRect.width() / 2.;
+                    cardRect.setWidth(width);
+                    const qreal height = cardRect.height() / (cardsCount / 2.);
+                    cardRect.setHeight(height);
                     //
-                    // Горизонтальные линии
+                    // Если крайняя в ряду карточка
                     //
-                    {
-                        const qreal height = pageRect.height() / (cardsCount / 2.);
-                        qreal summaryHeight = 0;
-                        while (summaryHeight + height < pageRect.height()) {
-                            summaryHeight += height;
-                            const QPointF p1 = pageRect.topLeft() + QPointF(0, summaryHeight);
-                            const QPointF p2 = pageRect.topRight() + QPointF(0, summaryHeight);
-                            painter.drawLine(p1, p2);
-                        }
-                    }
-                    //
-                    // Вертикальная линия
-                    //
-                    {
-                        const qreal width = pageRect.width() / 2.;
-                        const QPointF p1 = pageRect.topLeft() + QPointF(width, 0);
-                        const QPointF p2 = pageRect.bottomLeft() + QPointF(width, 0);
-                        painter.drawLine(p1, p2);
+                    if (currentCardIndex % 2 != 0) {
+                        //
+                        // ... смещаем область отрисовки
+                        //
+                        cardRect.moveLeft(cardRect.left() + width);
+                        //
+                        // ... и переходим к следующему ряду
+                        //
+                        lastY += height;
                     }
                     break;
                 }
             }
-            painter.restore();
-        }
 
-        //
-        // Определяем область на странице
-        //
-        QRectF cardRect = pageRect;
-        cardRect.moveTop(cardRect.top() + lastY);
-        switch (cardsCount) {
-            default:
-            case 1: {
-                //
-                // Вся страница
-                //
-                break;
+            //
+            // Дополнительные отступы от принтера
+            //
+            // ... снизу
+            //
+            if (cardRect.bottom() != pageRect.bottom()) {
+                cardRect.setBottom(cardRect.bottom() - sideMargin);
             }
-
-            case 2: {
-                const qreal height = cardRect.height() / 2.;
-                cardRect.setHeight(height);
-                lastY += height;
-                break;
+            //
+            // ... сверху
+            //
+            if (cardRect.top() != pageRect.top()) {
+                cardRect.setTop(cardRect.top() + sideMargin);
+            }
+            //
+            // ... слева
+            //
+            if (cardRect.left() != pageRect.left()) {
+                cardRect.setLeft(cardRect.left() + sideMargin);
+            }
+            //
+            // ... и справа
+            //
+            if (cardRect.right() != pageRect.right()) {
+                cardRect.setRight(cardRect.right() - sideMargin);
             }
 
-            case 4:
-            case 6:
-            case 8: {
-                const qreal width = cardRect.width() / 2.;
-                cardRect.setWidth(width);
-                const qreal height = cardRect.height() / (cardsCount / 2.);
-                cardRect.setHeight(height);
-                //
-                // Если крайняя в ряду карточка
-                //
-                if (currentCardIndex % 2 != 0) {
-                    //
-                    // ... смещаем область отрисовки
-                    //
-                    cardRect.moveLeft(cardRect.left() + width);
-                    //
-                    // ... и переходим к следующему ряду
-                    //
-                    lastY += height;
-                }
-                break;
+            //
+            // Дополнительные отступы для удобочитаемости
+            //
+            const int contentMargin = 6;
+            cardRect.setBottom(cardRect.bottom() - contentMargin);
+            cardRect.setTop(cardRect.top() + contentMargin);
+            cardRect.setLeft(cardRect.left() + contentMargin);
+            cardRect.setRight(cardRect.right() - contentMargin);
+
+            card.titleRect = QRectF(cardRect.left(), cardRect.top(), cardRect.width(), titleHeight);
+            const qreal spacing = card.titleRect.height() / 2;
+            card.descriptionRect = QRectF(card.titleRect.left(), card.titleRect.bottom() + spacing,
+                                          card.titleRect.width(), cardRect.height() - card.titleRect.height() - spacing);
+
+            //
+            // Переходим к следующей карточке
+            //
+            ++currentCardIndex;
+            if (currentCardIndex == cardsCount) {
+                currentCardIndex = 0;
+                lastY = 0;
             }
         }
 
         //
-        // Дополнительные отступы от принтера
-        //
-        // ... снизу
-        //
-        if (cardRect.bottom() != pageRect.bottom()) {
-            cardRect.setBottom(cardRect.bottom() - sideMargin);
-        }
-        //
-        // ... сверху
-        //
-        if (cardRect.top() != pageRect.top()) {
-            cardRect.setTop(cardRect.top() + sideMargin);
-        }
-        //
-        // ... слева
-        //
-        if (cardRect.left() != pageRect.left()) {
-            cardRect.setLeft(cardRect.left() + sideMargin);
-        }
+        // Самое затратное - подгонку текстов под размер карточек, выполняем параллельно
         //
-        // ... и справа
-        //
-        if (cardRect.right() != pageRect.right()) {
-            cardRect.setRight(cardRect.right() - sideMargin);
-        }
+        QtConcurrent::blockingMap(m_printedCards, [titleFont, descriptionFont] (PrintedCard& _card) {
+            QTextOption textoption;
+            textoption.setAlignment(Qt::AlignTop | Qt::AlignLeft);
+            textoption.setWrapMode(QTextOption::NoWrap);
+            _card.title = TextUtils::elidedText(_card.title, titleFont, _card.titleRect.size(), textoption);
 
+            textoption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+            _card.description =
+                    TextUtils::elidedText(_card.description, descriptionFont, _card.descriptionRect.size(), textoption);
+        });
+    }
+
+    //
+    // Покажем прогресс
+    //
+    int progress = 0;
+    m_printDialog->setProgressValue(progress);
+    m_printDialog->showProgress(0, m_printedCards.size());
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+
+    //
+    // Печатаем карточки
+    //
+    bool isFirst = true;
+    for (const PrintedCard& card : m_printedCards) {
         //
-        // Дополнительные отступы для удобочитаемости
+        // Обновляем значение прогресса не чаще, чем это заметно глазу
         //
-        const int contentMargin = 6;
-        cardRect.setBottom(cardRect.bottom() - contentMargin);
-        cardRect.setTop(cardRect.top() + contentMargin);
-        cardRect.setLeft(cardRect.left() + contentMargin);
-        cardRect.setRight(cardRect.right() - contentMargin);
+        ++progress;
+        if (progressTimer.hasExpired(PROGRESS_UPDATE_INTERVAL)) {
+            m_printDialog->setProgressValue(progress);
+            QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+            progressTimer.restart();
+        }
 
         //
-        // Рисуем карточку
+        // Если надо, переходим на новую страницу и рисуем линии разреза
         //
-        {
-            //
-            // Рисуем заголовок
-            //
-            QTextOption textoption;
-            textoption.setAlignment(Qt::AlignTop | Qt::AlignLeft);
-            textoption.setWrapMode(QTextOption::NoWrap);
-            QFont font = painter.font();
-            font.setBold(true);
-            painter.setFont(font);
-            const int titleHeight = painter.fontMetrics().height();
-            const QRectF titleRect(cardRect.left(), cardRect.top(), cardRect.width(), titleHeight);
-            QString titleText = item->name().isEmpty() ? item->header() : item->name();
-            if (item->type() == BusinessLogic::ScenarioModelItem::Scene) {
-                titleText.prepend(QString("%1. ").arg(item->sceneNumber()));
+        if (card.isPageStart) {
+            if (isFirst) {
+                isFirst = false;
+            } else {
+                _printer->newPage();
             }
-            titleText = TextUtils::elidedText(TextEditHelper::smartToUpper(titleText), painter.font(), titleRect.size(), textoption);
-            painter.drawText(titleRect, titleText, textoption);
 
-            //
-            // Рисуем описание
-            //
-            textoption.setAlignment(Qt::AlignTop | Qt::AlignLeft);
-            textoption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
-            font.setBold(false);
-            painter.setFont(font);
-            const qreal spacing = titleRect.height() / 2;
-            const QRectF descriptionRect(titleRect.left(), titleRect.bottom() + spacing, titleRect.width(), cardRect.height() - titleRect.height() - spacing);
-            QString descriptionText = item->description().isEmpty() ? item->fullText() : item->description();
-            descriptionText.replace("\n", "\n\n");
-            descriptionText = TextUtils::elidedText(descriptionText, painter.font(), descriptionRect.size(), textoption);
-            painter.drawText(descriptionRect, descriptionText, textoption);
+            painter.setClipRect(pageRect);
+            painter.save();
+            painter.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+            drawCutLines(painter, pageRect, cardsCount);
+            painter.restore();
         }
 
         //
-        // Переходим к следующей карточке
+        // Рисуем карточку
         //
-        ++currentCardIndex;
-        if (currentCardIndex == cardsCount) {
-            currentCardIndex = 0;
-            lastY = 0;
-        }
+        QTextOption textoption;
+        textoption.setAlignment(Qt::AlignTop | Qt::AlignLeft);
+        textoption.setWrapMode(QTextOption::NoWrap);
+        painter.setFont(titleFont);
+        painter.drawText(card.titleRect, card.title, textoption);
+
+        textoption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        painter.setFont(descriptionFont);
+        painter.drawText(card.descriptionRect, card.description, textoption);
     }
 
     //
@@ -3,11 +3,15 @@
 
 #include <QModelIndexList>
 #include <QObject>
+#include <QPersistentModelIndex>
+#include <QRectF>
+#include <QVector>
 
 class QPrinter;
 
 namespace BusinessLogic {
     class ScenarioModel;
+    class ScenarioModelItem;
 }
 
 namespace UserInterface {
@@ -42,7 +46,7 @@ namespace ManagementLayer
         /**
          * @brief Сохранить схему сценария
          */
-        QString save() const;
+        QString save();
 
         /**
          * @brief Сохранить изменения схемы
@@ -54,6 +58,14 @@ namespace ManagementLayer
          */
         void load(BusinessLogic::ScenarioModel* _model, const QString& _xml);
 
+        /**
+         * @brief Привести карточки схемы в соответствие с элементами модели
+         *
+         * Удаляет карточки, которых нет в модели, и добавляет недостающие, не трогая совпадающие.
+         * Схема строится заново, только если сцены были переставлены.
+         */
+        void syncWithModel();
+
         /**
          * @brief Очистить данные схемы и модель
          */
@@ -182,6 +194,79 @@ namespace ManagementLayer
         void printCards(QPrinter* _printer);
         /** @} */
 
+    private:
+        /**
+         * @brief Изменение модели, которое нужно отразить в карточках
+         */
+        struct CardChange {
+            /**
+             * @brief Тип изменения
+             */
+            enum Type {
+                Insert,
+                Update,
+                Remove
+            } type = Update;
+
+            /**
+             * @brief Индекс изменённого элемента модели
+             * @note Становится невалидным, если элемент будет удалён до применения изменения
+             */
+            QPersistentModelIndex index;
+
+            /**
+             * @brief Идентификатор карточки
+             */
+            QString uuid;
+
+            /**
+             * @brief Идентификатор карточки, после которой вставляется новая
+             */
+            QString previousCardUuid;
+        };
+
+        /**
+         * @brief Карточка, подготовленная к печати
+         */
+        struct PrintedCard {
+            /**
+             * @brief Начинается ли с карточки новая страница
+             */
+            bool isPageStart = false;
+
+            /**
+             * @brief Заголовок и область для него
+             */
+            /** @{ */
+            QString title;
+            QRectF titleRect;
+            /** @} */
+
+            /**
+             * @brief Текст и область для него
+             */
+            /** @{ */
+            QString description;
+            QRectF descriptionRect;
+            /** @} */
+        };
+
+        /**
+         * @brief Вставить карточку для элемента модели после заданной
+         */
+        void insertCard(const BusinessLogic::ScenarioModelItem* _item, const QString& _previousCardUuid);
+
+        /**
+         * @brief Запомнить изменение модели, чтобы применить его вместе с остальными
+         */
+        void addCardChange(CardChange::Type _type, const QModelIndex& _index, const QString& _uuid,
+            const QString& _previousCardUuid = QString());
+
+        /**
+         * @brief Применить накопленные изменения модели к карточкам
+         */
+        void applyCardChanges();
+
     private:
         /**
          * @brief Настроить соединения
@@ -208,6 +293,19 @@ namespace ManagementLayer
          * @brief Модель сценария
          */
         BusinessLogic::ScenarioModel* m_model = nullptr;
+
+        /**
+         * @brief Изменения модели, ещё не применённые к карточкам, в порядке их возникновения
+         */
+        QVector<CardChange> m_cardChanges;
+
+        /**
+         * @brief Раскладка карточек текущего сеанса печати и параметры, для которых она сформирована
+         */
+        /** @{ */
+        QVector<PrintedCard> m_printedCards;
+        QString m_printLayoutKey;
+        /** @} */
     };
 }
 
@@ -0,0 +1,130 @@
+#include "ScenarioChangesScheduler.h"
+
+using ManagementLayer::ScenarioChangesScheduler;
+
+namespace {
+    /**
+     * @brief Пауза в наборе, после которой формируются патчи, мс
+     * @note Не меньше секунды, чтобы отмена/повтор не дробились на отдельные символы
+     */
+    const int IDLE_INTERVAL = 1000;
+
+    /**
+     * @brief Максимальная задержка формирования патчей при непрерывном наборе, мс
+     */
+    const int MAX_LATENCY_INTERVAL = 5000;
+
+    /**
+     * @brief Интервалы синхронизации с облаком, когда соавторов нет и когда они есть, мс
+     */
+    /** @{ */
+    const int SLOW_HEARTBEAT_INTERVAL = 5000;
+    const int FAST_HEARTBEAT_INTERVAL = 1000;
+    /** @} */
+}
+
+
+ScenarioChangesScheduler::ScenarioChangesScheduler(QObject* _parent) :
+    QObject(_parent)
+{
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(IDLE_INTERVAL);
+    m_maxLatencyTimer.setSingleShot(true);
+    m_maxLatencyTimer.setInterval(MAX_LATENCY_INTERVAL);
+    m_heartbeatTimer.setInterval(SLOW_HEARTBEAT_INTERVAL);
+
+    connect(&m_idleTimer, &QTimer::timeout, this, &ScenarioChangesScheduler::requestCapture);
+    connect(&m_maxLatencyTimer, &QTimer::timeout, this, &ScenarioChangesScheduler::requestCapture);
+    connect(&m_heartbeatTimer, &QTimer::timeout, this, &ScenarioChangesScheduler::requestCapture);
+}
+
+void ScenarioChangesScheduler::start(bool _isRemote)
+{
+    stop();
+
+    m_isRemote = _isRemote;
+    m_ticks = 0;
+    m_emptyTicks = 0;
+    m_diffBytes = 0;
+
+    //
+    // Локальный проект изменяется только пользователем, поэтому опрашивать его нет смысла
+    //
+    if (m_isRemote) {
+        m_heartbeatTimer.start(SLOW_HEARTBEAT_INTERVAL);
+    }
+}
+
+void ScenarioChangesScheduler::stop()
+{
+    m_idleTimer.stop();
+    m_maxLatencyTimer.stop();
+    m_heartbeatTimer.stop();
+}
+
+bool ScenarioChangesScheduler::isRemote() const
+{
+    return m_isRemote;
+}
+
+void ScenarioChangesScheduler::setHasCoauthors(bool _hasCoauthors)
+{
+    if (!m_isRemote) {
+        return;
+    }
+
+    const int interval = _hasCoauthors ? FAST_HEARTBEAT_INTERVAL : SLOW_HEARTBEAT_INTERVAL;
+    if (m_heartbeatTimer.interval() != interval) {
+        m_heartbeatTimer.setInterval(interval);
+    }
+}
+
+void ScenarioChangesScheduler::scheduleCapture()
+{
+    //
+    // Каждое изменение отодвигает формирование патчей до паузы в наборе...
+    //
+    m_idleTimer.start();
+
+    //
+    // ... но не дальше, чем на максимальную задержку от первого несохранённого изменения
+    //
+    if (!m_maxLatencyTimer.isActive()) {
+        m_maxLatencyTimer.start();
+    }
+}
+
+void ScenarioChangesScheduler::registerCapture(int _diffBytes)
+{
+    m_idleTimer.stop();
+    m_maxLatencyTimer.stop();
+
+    ++m_ticks;
+    if (_diffBytes == 0) {
+        ++m_emptyTicks;
+    }
+    m_diffBytes += _diffBytes;
+}
+
+int ScenarioChangesScheduler::ticks() const
+{
+    return m_ticks;
+}
+
+int ScenarioChangesScheduler::emptyTicks() const
+{
+    return m_emptyTicks;
+}
+
+qint64 ScenarioChangesScheduler::diffBytes() const
+{
+    return m_diffBytes;
+}
+
+void ScenarioChangesScheduler::requestCapture()
+{
+    m_idleTimer.stop();
+    m_maxLatencyTimer.stop();
+
+    emit captureRequested();
+}
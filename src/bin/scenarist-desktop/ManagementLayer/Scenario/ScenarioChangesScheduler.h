@@ -0,0 +1,111 @@
+#ifndef SCENARIOCHANGESSCHEDULER_H
+#define SCENARIOCHANGESSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Планировщик формирования патчей изменений сценария
+     *
+     * Вместо постоянного опроса документов с фиксированным интервалом запрашивает формирование
+     * патчей, когда пользователь сделал паузу в наборе, но не реже заданного интервала при
+     * непрерывном наборе. Для проектов из облака дополнительно периодически запрашивает
+     * синхронизацию, чтобы получать изменения соавторов, и делает это чаще, когда соавторы
+     * работают с проектом одновременно с пользователем.
+     */
+    class ScenarioChangesScheduler : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ScenarioChangesScheduler(QObject* _parent = nullptr);
+
+        /**
+         * @brief Запустить планирование
+         * @param _isRemote - работает ли пользователь с проектом из облака
+         */
+        void start(bool _isRemote);
+
+        /**
+         * @brief Остановить планирование
+         */
+        void stop();
+
+        /**
+         * @brief Работает ли пользователь с проектом из облака
+         */
+        bool isRemote() const;
+
+        /**
+         * @brief Установить, работают ли с проектом соавторы
+         */
+        void setHasCoauthors(bool _hasCoauthors);
+
+        /**
+         * @brief Запланировать формирование патчей после изменения документа
+         */
+        void scheduleCapture();
+
+        /**
+         * @brief Учесть выполненное формирование патчей
+         * @param _diffBytes - размер сформированных патчей, 0, если изменений не было
+         */
+        void registerCapture(int _diffBytes);
+
+        /**
+         * @brief Счётчики работы планировщика
+         */
+        /** @{ */
+        int ticks() const;
+        int emptyTicks() const;
+        qint64 diffBytes() const;
+        /** @} */
+
+    signals:
+        /**
+         * @brief Необходимо сформировать патчи изменений
+         */
+        void captureRequested();
+
+    private:
+        /**
+         * @brief Обработать срабатывание одного из таймеров
+         */
+        void requestCapture();
+
+    private:
+        /**
+         * @brief Таймер паузы в наборе текста
+         */
+        QTimer m_idleTimer;
+
+        /**
+         * @brief Таймер максимальной задержки формирования патчей при непрерывном наборе
+         */
+        QTimer m_maxLatencyTimer;
+
+        /**
+         * @brief Таймер периодической синхронизации с облаком
+         */
+        QTimer m_heartbeatTimer;
+
+        /**
+         * @brief Работает ли пользователь с проектом из облака
+         */
+        bool m_isRemote = false;
+
+        /**
+         * @brief Количество формирований патчей, из них пустых, и общий размер патчей
+         */
+        /** @{ */
+        int m_ticks = 0;
+        int m_emptyTicks = 0;
+        qint64 m_diffBytes = 0;
+        /** @} */
+    };
+}
+
+#endif // SCENARIOCHANGESSCHEDULER_H
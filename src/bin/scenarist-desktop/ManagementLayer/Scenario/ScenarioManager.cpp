@@ -1,11 +1,14 @@
 #include "ScenarioManager.h"
 
 #include "ScenarioCardsManager.h"
+#include "ScenarioChangesScheduler.h"
 #include "ScenarioNavigatorManager.h"
 #include "ScenarioSceneDescriptionManager.h"
 #include "ScenarioTextEditManager.h"
 #include "ScriptBookmarksManager.h"
 #include "ScriptDictionariesManager.h"
+#include "ScriptDurationIndex.h"
+#include "ScriptNamesIndex.h"
 
 #include <Domain/Research.h>
 #include <Domain/Scenario.h>
@@ -15,7 +18,6 @@
 #include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioModelItem.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
-#include <BusinessLayer/ScenarioDocument/ScenarioTextBlockParsers.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
 #include <BusinessLayer/ScenarioDocument/ScenarioModel.h>
 #include <BusinessLayer/ScenarioDocument/ScriptTextCursor.h>
@@ -37,6 +39,8 @@
 
 #include <QApplication>
 #include <QComboBox>
+#include <QDebug>
+#include <QHash>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QShortcut>
@@ -51,11 +55,14 @@
 
 using ManagementLayer::ScenarioManager;
 using ManagementLayer::ScenarioCardsManager;
+using ManagementLayer::ScenarioChangesScheduler;
 using ManagementLayer::ScenarioNavigatorManager;
 using ManagementLayer::ScenarioSceneDescriptionManager;
 using ManagementLayer::ScenarioTextEditManager;
 using ManagementLayer::ScriptBookmarksManager;
 using ManagementLayer::ScriptDictionariesManager;
+using ManagementLayer::ScriptDurationIndex;
+using ManagementLayer::ScriptNamesIndex;
 using BusinessLogic::ScenarioDocument;
 using BusinessLogic::ScenarioBlockStyle;
 using BusinessLogic::ScriptTextCursor;
@@ -66,15 +73,6 @@ namespace {
      */
     const bool IS_DRAFT = true;
 
-    /**
-     * @brief Интервалы формирования патчей для отмены/повтора последнего действия, мс
-     * @note Минимальный интервал = 1 секунда
-     */
-    /** @{ */
-    const int SLOW_SAVE_CHANGES_INTERVAL = 5000;
-    const int FAST_SAVE_CHANGES_INTERVAL = 1000;
-    /** @} */
-
     /**
      * @brief Индексы дополнительных панелей в навигаторе
      */
@@ -86,155 +84,80 @@ namespace {
     /** @} */
 
     /**
-     * @brief Обновить текст сценария для нового имени персонажа
+     * @brief Обновить цвета текста и фона блоков для заданного документа
+     *
+     * Стили блоков берутся из шаблона по одному разу для каждого типа, а форматы документа
+     * изменяются только там, где они действительно отличаются от стиля
      */
-    static void updateScenarioForNewCharacterName(ScenarioDocument* _scenario,
-        const QString _oldName, const QString& _newName) {
-
-        QTextCursor cursor(_scenario->document());
-        while (!cursor.isNull() && !cursor.atEnd()) {
-            cursor = _scenario->document()->find(_oldName, cursor);
-
-            if (!cursor.isNull()) {
-                //
-                // Выделенным должно быть именно имя, а не составная часть другого имени
-                //
-                bool replaceSelection = false;
-
-                //
-                // Если мы в блоке персонажа
-                //
-                if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::Character) {
-                    const QString name = BusinessLogic::CharacterParser::name(cursor.block().text());
-                    if (name == TextEditHelper::smartToUpper(cursor.selectedText())) {
-                        replaceSelection = true;
-                    }
-                }
-                //
-                // Если в блоке участники сцены
-                //
-                else if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::SceneCharacters) {
-                    const QStringList names = BusinessLogic::SceneCharactersParser::characters(cursor.block().text());
-                    if (names.contains(TextEditHelper::smartToUpper(cursor.selectedText()))) {
-                        //
-                        // Убедимся, что выделено именно имя, а не часть другого имени
-                        //
-                        QTextCursor checkCursor(cursor);
-                        // ... всё ли в порядке слева
-                        bool atLeftAllOk = false;
-                        checkCursor.setPosition(cursor.selectionStart());
-                        if (checkCursor.atBlockStart()) {
-                            atLeftAllOk = true;
-                        } else {
-                            checkCursor.movePosition(QTextCursor::PreviousCharacter, QTextCursor::KeepAnchor);
-                            if (checkCursor.selectedText() == " "
-                                || checkCursor.selectedText() == ",") {
-                                atLeftAllOk = true;
-                            } else {
-                                atLeftAllOk = false;
-                            }
-                        }
-                        // ... всё ли в порядке справа
-                        bool atRightAllOk = false;
-                        checkCursor.setPosition(cursor.selectionEnd());
-                        if (checkCursor.atBlockEnd()) {
-                            atRightAllOk = true;
-                        } else {
-                            checkCursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
-                            if (checkCursor.selectedText() == " "
-                                || checkCursor.selectedText() == ",") {
-                                atRightAllOk = true;
-                            } else {
-                                atRightAllOk = false;
-                            }
-                        }
-                        // ... если со всех сторон всё в порядке - заменяем
-                        if (atLeftAllOk && atRightAllOk) {
-                            replaceSelection = true;
-                        }
-                    }
-                }
+    static void updateDocumentBlocksColors(QTextDocument* _document) {
+        const BusinessLogic::ScenarioTemplate& scenarioTemplate =
+                BusinessLogic::ScenarioTemplateFacade::getTemplate();
+        QHash<int, ScenarioBlockStyle> blockStyles;
 
-                //
-                // Если выделено имя для замены, меняем его
-                //
-                if (replaceSelection) {
-                    cursor.insertText(_newName);
-                }
+        ScriptTextCursor cursor(_document);
+        cursor.beginEditBlock();
+        for (QTextBlock block = _document->begin(); block.isValid(); block = block.next()) {
+            const ScenarioBlockStyle::Type blockType = ScenarioBlockStyle::forBlock(block);
+            if (!blockStyles.contains(blockType)) {
+                blockStyles.insert(blockType, scenarioTemplate.blockStyle(blockType));
             }
-        }
-    }
+            const ScenarioBlockStyle& blockStyle = blockStyles[blockType];
+            const QTextCharFormat& styleCharFormat = blockStyle.charFormat();
 
-    static void updateScenarioForNewLocationName(ScenarioDocument* _scenario,
-        const QString& _oldName, const QString& _newName) {
-
-        QTextCursor cursor(_scenario->document());
-        while (!cursor.isNull() && !cursor.atEnd()) {
-            cursor = _scenario->document()->find(_oldName, cursor);
-
-            if (!cursor.isNull()) {
-                //
-                // Выделенным должно быть именно локация, а не составная часть другой локации
-                //
-                bool replaceSelection = false;
-
-                //
-                // Если мы в блоке времени и места
-                //
-                if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::SceneHeading) {
-                    const QString location = BusinessLogic::SceneHeadingParser::locationName(cursor.block().text());
-                    if (location == TextEditHelper::smartToUpper(cursor.selectedText())) {
-                        replaceSelection = true;
-                    }
+            //
+            // Обновляем форматы самого блока, если они отличаются от стиля
+            //
+            cursor.setPosition(block.position());
+            QTextBlockFormat blockFormat = block.blockFormat();
+            blockFormat.merge(blockStyle.blockFormat());
+            if (blockFormat != block.blockFormat()) {
+                cursor.mergeBlockFormat(blockStyle.blockFormat());
+            }
+            QTextCharFormat blockCharFormat = block.charFormat();
+            blockCharFormat.merge(styleCharFormat);
+            if (blockCharFormat != block.charFormat()) {
+                cursor.mergeBlockCharFormat(styleCharFormat);
+            }
+
+            //
+            // Определяем какие части текста блока нужно обновить
+            //
+            bool hasReviewMarks = false;
+            QVector<QTextLayout::FormatRange> rangesToUpdate;
+            foreach (const QTextLayout::FormatRange& range, block.textFormats()) {
+                if (range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark)) {
+                    hasReviewMarks = true;
+                    continue;
                 }
 
-                //
-                // Если выделено имя для замены, меняем его
-                //
-                if (replaceSelection) {
-                    cursor.insertText(_newName);
+                QTextCharFormat charFormat = range.format;
+                charFormat.merge(styleCharFormat);
+                if (charFormat != range.format) {
+                    rangesToUpdate.append(range);
                 }
             }
-        }
-    }
+            if (rangesToUpdate.isEmpty()) {
+                continue;
+            }
 
-    /**
-     * @brief Обновить цвета текста и фона блоков для заданного документа
-     */
-    static void updateDocumentBlocksColors(QTextDocument* _document) {
-        ScriptTextCursor cursor(_document);
-        cursor.beginEditBlock();
-        do {
-            cursor.movePosition(QTextCursor::StartOfBlock);
-            ScenarioBlockStyle blockStyle
-                    = BusinessLogic::ScenarioTemplateFacade::getTemplate().blockStyle(cursor.block());
             //
-            // Если в блоке есть выделения, обновляем цвет только тех частей, которые не входят в выделения
+            // Если в блоке нет выделений, обновляем его текст целиком
             //
-            QTextBlock currentBlock = cursor.block();
-            if (!currentBlock.textFormats().isEmpty()) {
-                foreach (const QTextLayout::FormatRange& range, currentBlock.textFormats()) {
-                    if (!range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark)) {
-                        cursor.setPosition(currentBlock.position() + range.start);
-                        cursor.setPosition(cursor.position() + range.length, QTextCursor::KeepAnchor);
-                        cursor.mergeCharFormat(blockStyle.charFormat());
-                        cursor.mergeBlockCharFormat(blockStyle.charFormat());
-                        cursor.mergeBlockFormat(blockStyle.blockFormat());
-                    }
-                }
-                cursor.movePosition(QTextCursor::EndOfBlock);
+            if (!hasReviewMarks) {
+                cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+                cursor.mergeCharFormat(styleCharFormat);
             }
             //
-            // Если выделений нет, обновляем блок целиком
+            // А если есть, то обновляем цвет только тех частей, которые не входят в выделения
             //
             else {
-                cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
-                cursor.mergeCharFormat(blockStyle.charFormat());
-                cursor.mergeBlockCharFormat(blockStyle.charFormat());
-                cursor.mergeBlockFormat(blockStyle.blockFormat());
+                foreach (const QTextLayout::FormatRange& range, rangesToUpdate) {
+                    cursor.setPosition(block.position() + range.start);
+                    cursor.setPosition(cursor.position() + range.length, QTextCursor::KeepAnchor);
+                    cursor.mergeCharFormat(styleCharFormat);
+                }
             }
-            cursor.movePosition(QTextCursor::NextBlock);
-        } while (!cursor.atEnd());
+        }
         cursor.endEditBlock();
     }
 }
@@ -342,6 +265,13 @@ void ScenarioManager::loadCurrentProject()
     //
     m_cardsManager->load(m_scenario->model(), currentScenario->scheme());
 
+    //
+    // Только что загруженные данные совпадают с сохранёнными
+    //
+    m_isScenarioChanged = false;
+    m_isScenarioDraftChanged = false;
+    m_isCardsSchemeChanged = false;
+
     //
     // Обновим счётчики, когда данные полностью загрузятся
     //
@@ -351,17 +281,31 @@ void ScenarioManager::loadCurrentProject()
 void ScenarioManager::rebuildCardsFromScript()
 {
     //
-    // Передаём пустую строку вместо схемы, чтобы карточки построились из текста сценария
+    // Схема могла быть сохранена для другого состава сцен, например, если сцены пришли
+    // с синхронизацией, поэтому приводим карточки в соответствие со сценарием, перестраивая
+    // только отличающиеся, а изменения текста сцен уже отражены в карточках
     //
-    m_cardsManager->load(m_scenario->model(), QString());
+    m_cardsManager->syncWithModel();
 }
 
-void ScenarioManager::startChangesHandling()
+void ScenarioManager::startChangesHandling(bool _isRemote)
 {
     //
-    // Запускаем таймер сохранения изменений
+    // Только что загруженные документы не содержат изменений для формирования патчей
+    //
+    m_hasUncapturedScenarioChanges = false;
+    m_hasUncapturedScenarioDraftChanges = false;
+    m_hasUncapturedCardsChanges = false;
+
+    //
+    // Запускаем планировщик формирования патчей изменений
     //
-    m_saveChangesTimer.start(SLOW_SAVE_CHANGES_INTERVAL);
+    m_changesScheduler->start(_isRemote);
+}
+
+const ScenarioChangesScheduler* ScenarioManager::changesScheduler() const
+{
+    return m_changesScheduler;
 }
 
 void ScenarioManager::loadCurrentProjectSettings(const QString& _projectPath)
@@ -390,17 +334,31 @@ void ScenarioManager::loadCurrentProjectSettings(const QString& _projectPath)
 void ScenarioManager::saveCurrentProject()
 {
     //
-    // Сохраняем сценарий
+    // Сохраняем сценарий, если он, или его схема изменились
     //
-    m_scenario->scenario()->setText(m_scenario->save());
-    m_scenario->scenario()->setScheme(m_cardsManager->save());
-    DataStorageLayer::StorageFacade::scenarioStorage()->storeScenario(m_scenario->scenario());
+    // NOTE: Схема карточек строится по модели сценария, поэтому при изменении текста
+    //       её так же необходимо пересохранить
+    //
+    if (m_isScenarioChanged || m_isCardsSchemeChanged) {
+        if (m_isScenarioChanged) {
+            m_scenario->scenario()->setText(m_scenario->save());
+        }
+        m_scenario->scenario()->setScheme(m_cardsManager->save());
+        DataStorageLayer::StorageFacade::scenarioStorage()->storeScenario(m_scenario->scenario());
+
+        m_isScenarioChanged = false;
+        m_isCardsSchemeChanged = false;
+    }
 
     //
-    // Сохраняем черновик
+    // Сохраняем черновик, если он изменился
     //
-    m_scenarioDraft->scenario()->setText(m_scenarioDraft->save());
-    DataStorageLayer::StorageFacade::scenarioStorage()->storeScenario(m_scenarioDraft->scenario());
+    if (m_isScenarioDraftChanged) {
+        m_scenarioDraft->scenario()->setText(m_scenarioDraft->save());
+        DataStorageLayer::StorageFacade::scenarioStorage()->storeScenario(m_scenarioDraft->scenario());
+
+        m_isScenarioDraftChanged = false;
+    }
 
     //
     // Сохраняем изменения
@@ -409,6 +367,13 @@ void ScenarioManager::saveCurrentProject()
     DataStorageLayer::StorageFacade::scenarioChangeStorage()->store();
 }
 
+void ScenarioManager::markCurrentProjectChanged()
+{
+    m_isScenarioChanged = true;
+    m_isScenarioDraftChanged = true;
+    m_isCardsSchemeChanged = true;
+}
+
 void ScenarioManager::saveCurrentProjectSettings(const QString& _projectPath)
 {
     //
@@ -431,9 +396,14 @@ void ScenarioManager::saveCurrentProjectSettings(const QString& _projectPath)
 void ScenarioManager::closeCurrentProject()
 {
     //
-    // Остановим таймер сохранения изменений документа
+    // Остановим планировщик формирования патчей изменений документа
     //
-    m_saveChangesTimer.stop();
+    m_changesScheduler->stop();
+#ifndef QT_NO_DEBUG
+    qDebug() << "Changes scheduler:" << m_changesScheduler->ticks() << "captures,"
+             << m_changesScheduler->emptyTicks() << "empty,"
+             << m_changesScheduler->diffBytes() << "patch bytes";
+#endif
 
     //
     // Очистим от предыдущих данных
@@ -449,6 +419,10 @@ void ScenarioManager::closeCurrentProject()
     //
     m_scenario->clear();
     m_scenarioDraft->clear();
+
+    m_isScenarioChanged = false;
+    m_isScenarioDraftChanged = false;
+    m_isCardsSchemeChanged = false;
 }
 
 void ScenarioManager::setCommentOnly(bool _isCommentOnly)
@@ -504,6 +478,13 @@ void ScenarioManager::aboutTextEditSettingsUpdated()
     // Корректируем текст, т.к. могли измениться настройки отображения, или используемого шаблона
     //
     m_scenario->document()->correct();
+
+    //
+    // Хронометраж блоков зависит от шаблона и формата страницы, поэтому пересчитываем его
+    //
+    m_scenarioDurationIndex->invalidate();
+    m_scenarioDraftDurationIndex->invalidate();
+    aboutUpdateDuration(m_textEditManager->cursorPosition());
 }
 
 void ScenarioManager::aboutNavigatorSettingsUpdated()
@@ -529,29 +510,28 @@ void ScenarioManager::aboutCharacterNameChanged(const QString& _oldName, const Q
     //
     // Обновить тексты всех сценариев
     //
-    ::updateScenarioForNewCharacterName(m_scenario, _oldName, _newName);
-    ::updateScenarioForNewCharacterName(m_scenarioDraft, _oldName, _newName);
+    m_scenarioNamesIndex->renameCharacter(_oldName, _newName);
+    m_scenarioDraftNamesIndex->renameCharacter(_oldName, _newName);
 }
 
 void ScenarioManager::aboutRefreshCharacters()
 {
     //
-    // Найти персонажей во всём тексте
+    // Берём персонажей из индексов текста, которые поддерживаются в актуальном состоянии при редактировании
     //
-    QSet<QString> characters = QSet<QString>::fromList(m_scenario->findCharacters());
-    characters.unite(QSet<QString>::fromList(m_scenarioDraft->findCharacters()));
+    QSet<QString> characters = m_scenarioNamesIndex->characters();
+    characters.unite(m_scenarioDraftNamesIndex->characters());
 
     //
-    // Определить персонажи, которых нет в тексте
+    // Определить персонажи, которых нет в тексте, и новые
     //
-    QSet<QString> charactersToDelete;
+    QSet<QString> storedCharacters;
     foreach (DomainObject* domainObject,
              DataStorageLayer::StorageFacade::researchStorage()->characters()->toList()) {
-        Research* character = dynamic_cast<Research*>(domainObject);
-        if (!characters.contains(character->name())) {
-            charactersToDelete.insert(character->name());
-        }
+        storedCharacters.insert(dynamic_cast<Research*>(domainObject)->name());
     }
+    const QSet<QString> charactersToDelete = storedCharacters - characters;
+    const QSet<QString> charactersToAdd = characters - storedCharacters;
 
     //
     // Спросить пользователя, хочет ли он выполнить это действие
@@ -570,22 +550,14 @@ void ScenarioManager::aboutRefreshCharacters()
     }
     if (QLightBoxMessage::question(m_view, tr("Apply refreshing"), message) == QDialogButtonBox::Yes) {
         //
-        // Удалить тех, кого нет
+        // Удалить тех, кого нет, и добавить новых одной транзакцией
         //
         DatabaseLayer::Database::transaction();
         foreach (const QString& character, charactersToDelete) {
             DataStorageLayer::StorageFacade::researchStorage()->removeCharacter(character);
         }
-        DatabaseLayer::Database::commit();
-
-        //
-        // Добавить новых
-        //
-        DatabaseLayer::Database::transaction();
-        foreach (const QString& character, characters) {
-            if (!DataStorageLayer::StorageFacade::researchStorage()->hasCharacter(character)) {
-                DataStorageLayer::StorageFacade::researchStorage()->storeCharacter(character);
-            }
+        foreach (const QString& character, charactersToAdd) {
+            DataStorageLayer::StorageFacade::researchStorage()->storeCharacter(character);
         }
         DatabaseLayer::Database::commit();
     }
@@ -596,29 +568,28 @@ void ScenarioManager::aboutLocationNameChanged(const QString& _oldName, const QS
     //
     // Обновить тексты всех сценариев
     //
-    ::updateScenarioForNewLocationName(m_scenario, _oldName, _newName);
-    ::updateScenarioForNewLocationName(m_scenarioDraft, _oldName, _newName);
+    m_scenarioNamesIndex->renameLocation(_oldName, _newName);
+    m_scenarioDraftNamesIndex->renameLocation(_oldName, _newName);
 }
 
 void ScenarioManager::aboutRefreshLocations()
 {
     //
-    // Найти локации во всём тексте
+    // Берём локации из индексов текста, которые поддерживаются в актуальном состоянии при редактировании
     //
-    QSet<QString> locations = QSet<QString>::fromList(m_scenario->findLocations());
-    locations.unite(QSet<QString>::fromList(m_scenarioDraft->findLocations()));
+    QSet<QString> locations = m_scenarioNamesIndex->locations();
+    locations.unite(m_scenarioDraftNamesIndex->locations());
 
     //
-    // Определить локации, которых нет в тексте
+    // Определить локации, которых нет в тексте, и новые
     //
-    QSet<QString> locationsToDelete;
+    QSet<QString> storedLocations;
     foreach (DomainObject* domainObject,
              DataStorageLayer::StorageFacade::researchStorage()->locations()->toList()) {
-        Research* location = dynamic_cast<Research*>(domainObject);
-        if (!locations.contains(location->name())) {
-            locationsToDelete.insert(location->name());
-        }
+        storedLocations.insert(dynamic_cast<Research*>(domainObject)->name());
     }
+    const QSet<QString> locationsToDelete = storedLocations - locations;
+    const QSet<QString> locationsToAdd = locations - storedLocations;
 
     //
     // Спросить пользователя, хочет ли он выполнить это действие
@@ -638,22 +609,14 @@ void ScenarioManager::aboutRefreshLocations()
 
     if (QLightBoxMessage::question(m_view, tr("Apply refreshing"), message) == QDialogButtonBox::Yes) {
         //
-        // Удалить те, которых нет
+        // Удалить те, которых нет, и добавить новых одной транзакцией
         //
         DatabaseLayer::Database::transaction();
         foreach (const QString& location, locationsToDelete) {
             DataStorageLayer::StorageFacade::researchStorage()->removeLocation(location);
         }
-        DatabaseLayer::Database::commit();
-
-        //
-        // Добавить новых
-        //
-        DatabaseLayer::Database::transaction();
-        foreach (const QString& location, locations) {
-            if (!DataStorageLayer::StorageFacade::researchStorage()->hasLocation(location)) {
-                DataStorageLayer::StorageFacade::researchStorage()->storeLocation(location);
-            }
+        foreach (const QString& location, locationsToAdd) {
+            DataStorageLayer::StorageFacade::researchStorage()->storeLocation(location);
         }
         DatabaseLayer::Database::commit();
     }
@@ -736,15 +699,12 @@ void ScenarioManager::aboutCursorsUpdated(const QMap<QString, int>& _cursors, bo
     }
 
     //
-    // Изменим время синхронизации документа с облаком.
-    // Конечно, setInterval перезапускает таймер, но в этом нет ничего страшного,
-    // поскольку только что было сохранение и время отсчитывается заново.
+    // Изменим частоту синхронизации документа с облаком.
     // Интервал устанавливается только при _isDraft = true, чтобы не устанавливать
     // его дважды при сохраненнии (на всяки случай)
     //
     if (_isDraft) {
-        m_saveChangesTimer.setInterval((m_draftCursors.isEmpty() && m_cleanCursors.isEmpty())
-                                       ? SLOW_SAVE_CHANGES_INTERVAL : FAST_SAVE_CHANGES_INTERVAL);
+        m_changesScheduler->setHasCoauthors(!m_draftCursors.isEmpty() || !m_cleanCursors.isEmpty());
     }
 }
 
@@ -805,6 +765,11 @@ void ScenarioManager::aboutRedo()
 
 void ScenarioManager::aboutRefreshDuration(int _cursorPosition)
 {
+    //
+    // Хронометраж блоков зависит от настроек, поэтому после их смены пересчитываем его заново
+    //
+    m_scenarioDurationIndex->invalidate();
+    m_scenarioDraftDurationIndex->invalidate();
     if (BusinessLogic::ChronometerFacade::chronometryUsed()) {
         workingScenario()->refresh();
     }
@@ -815,10 +780,16 @@ void ScenarioManager::aboutUpdateDuration(int _cursorPosition)
 {
     QString duration;
     if (BusinessLogic::ChronometerFacade::chronometryUsed()) {
+        //
+        // Берём хронометраж из индекса, чтобы не пересчитывать его по всему документу
+        // при каждом перемещении курсора
+        //
+        ScriptDurationIndex* durationIndex =
+                m_workModeIsDraft ? m_scenarioDraftDurationIndex : m_scenarioDurationIndex;
         QString durationToCursor =
-                BusinessLogic::ChronometerFacade::secondsToTime(workingScenario()->durationAtPosition(_cursorPosition));
+                BusinessLogic::ChronometerFacade::secondsToTime(durationIndex->durationAtPosition(_cursorPosition));
         QString durationToEnd =
-                BusinessLogic::ChronometerFacade::secondsToTime(workingScenario()->fullDuration());
+                BusinessLogic::ChronometerFacade::secondsToTime(durationIndex->fullDuration());
         duration = QString("%1: <b>%2 | %3</b>").arg(tr("Chron.")).arg(durationToCursor).arg(durationToEnd);
     }
 
@@ -838,6 +809,15 @@ void ScenarioManager::aboutUpdateCounters()
 
 void ScenarioManager::aboutUpdateCurrentSceneTitleAndDescription(int _cursorPosition)
 {
+    //
+    // Пока курсор перемещается в пределах одной сцены, её название и описание не меняются
+    //
+    const QModelIndex sceneIndex = workingScenario()->itemIndexAtPosition(_cursorPosition);
+    if (m_cursorSceneIndex.isValid() && m_cursorSceneIndex == sceneIndex) {
+        return;
+    }
+    m_cursorSceneIndex = sceneIndex;
+
     QString itemTitle = workingScenario()->itemTitleAtPosition(_cursorPosition);
     if (itemTitle.isEmpty()) {
         //
@@ -971,6 +951,7 @@ void ScenarioManager::aboutSetItemsColors(const QModelIndexList& _indexes, const
     }
     m_textEditManager->view()->update();
 
+    markWorkingScenarioChanged();
     emit scenarioChanged();
 }
 
@@ -982,6 +963,7 @@ void ScenarioManager::aboutSetItemStamp(const QModelIndex& _itemIndex, const QSt
     workingScenario()->setItemStampAtPosition(position, _stamp);
     m_textEditManager->view()->update();
 
+    markWorkingScenarioChanged();
     emit scenarioChanged();
 }
 
@@ -992,6 +974,7 @@ void ScenarioManager::aboutChangeItemType(const QModelIndex& _index, int _type)
     const int position = workingScenario()->itemStartPosition(_index);
     m_textEditManager->changeItemType(position, _type);
 
+    markWorkingScenarioChanged();
     emit scenarioChanged();
 }
 
@@ -1028,25 +1011,58 @@ void ScenarioManager::setNavigatorPanelVisible(int _panelIndex, bool _visible)
 
 void ScenarioManager::aboutSaveScenarioChanges()
 {
+    //
+    // Формируем патчи только для тех документов, которые изменились с прошлого раза
+    //
+    int diffBytes = 0;
+    const auto changeSize = [] (const Domain::ScenarioChange* _change) {
+        return _change->undoPatch().toUtf8().size() + _change->redoPatch().toUtf8().size();
+    };
+
     //
     // Сохраняем изменения сценария
     //
-    Domain::ScenarioChange* change = m_scenario->document()->saveChanges();
-    if (change != nullptr) {
-        change->setIsDraft(false);
+    Domain::ScenarioChange* change = nullptr;
+    if (m_hasUncapturedScenarioChanges) {
+        change = m_scenario->document()->saveChanges();
+        if (change != nullptr) {
+            change->setIsDraft(false);
+            diffBytes += changeSize(change);
+        }
     }
     //
     // ... и черновика
     //
-    Domain::ScenarioChange* changeDraft = m_scenarioDraft->document()->saveChanges();
-    if (changeDraft != nullptr) {
-        changeDraft->setIsDraft(true);
+    if (m_hasUncapturedScenarioDraftChanges) {
+        Domain::ScenarioChange* changeDraft = m_scenarioDraft->document()->saveChanges();
+        if (changeDraft != nullptr) {
+            changeDraft->setIsDraft(true);
+            diffBytes += changeSize(changeDraft);
+        }
     }
 
     //
     // Сохраняем изменения в карточках
     //
-    m_cardsManager->saveChanges(change != nullptr);
+    const bool hasChanges = m_hasUncapturedScenarioChanges
+                            || m_hasUncapturedScenarioDraftChanges
+                            || m_hasUncapturedCardsChanges;
+    if (m_hasUncapturedCardsChanges || change != nullptr) {
+        m_cardsManager->saveChanges(change != nullptr);
+    }
+
+    m_hasUncapturedScenarioChanges = false;
+    m_hasUncapturedScenarioDraftChanges = false;
+    m_hasUncapturedCardsChanges = false;
+    m_changesScheduler->registerCapture(diffBytes);
+
+    //
+    // Если в локальном проекте ничего не изменилось, то и обновлять нечего,
+    // а для проекта из облака нужно в любом случае получить изменения соавторов
+    //
+    if (!hasChanges && !m_changesScheduler->isRemote()) {
+        return;
+    }
 
 #ifdef Q_OS_MAC
     //
@@ -1068,6 +1084,13 @@ void ScenarioManager::aboutSaveScenarioChanges()
 
 void ScenarioManager::initData()
 {
+    m_changesScheduler = new ScenarioChangesScheduler(this);
+
+    m_scenarioNamesIndex = new ScriptNamesIndex(m_scenario->document());
+    m_scenarioDraftNamesIndex = new ScriptNamesIndex(m_scenarioDraft->document());
+    m_scenarioDurationIndex = new ScriptDurationIndex(m_scenario->document());
+    m_scenarioDraftDurationIndex = new ScriptDurationIndex(m_scenarioDraft->document());
+
     m_navigatorManager->setNavigationModel(m_scenario->model());
     m_draftNavigatorManager->setNavigationModel(m_scenarioDraft->model());
     m_scriptBookmarksManager->setBookmarksModel(m_scenario->document()->bookmarksModel());
@@ -1140,6 +1163,19 @@ void ScenarioManager::initConnections()
 
     connect(m_showFullscreen, &FlatButton::clicked, this, &ScenarioManager::showFullscreen);
 
+    //
+    // Любое изменение модели может изменить название, или описание сцены под курсором
+    //
+    auto resetCursorScene = [this] { m_cursorSceneIndex = QModelIndex(); };
+    foreach (BusinessLogic::ScenarioModel* model,
+             QList<BusinessLogic::ScenarioModel*>() << m_scenario->model() << m_scenarioDraft->model()) {
+        connect(model, &QAbstractItemModel::dataChanged, this, resetCursorScene);
+        connect(model, &QAbstractItemModel::rowsInserted, this, resetCursorScene);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, resetCursorScene);
+        connect(model, &QAbstractItemModel::rowsMoved, this, resetCursorScene);
+        connect(model, &QAbstractItemModel::modelReset, this, resetCursorScene);
+    }
+
     connect(m_cardsManager, &ScenarioCardsManager::goToCardRequest, this, &ScenarioManager::aboutGoToItemFromCards);
     connect(m_cardsManager, &ScenarioCardsManager::addCardRequest, this, &ScenarioManager::aboutAddItemFromCards);
     connect(m_cardsManager, &ScenarioCardsManager::updateCardRequest, this, &ScenarioManager::aboutUpdateItemFromCards);
@@ -1205,13 +1241,19 @@ void ScenarioManager::initConnections()
         } else {
             m_scenario->setNewSceneNumber(_newSceneNumber, _position);
         }
+        markWorkingScenarioChanged();
     });
 
-    connect(&m_saveChangesTimer, SIGNAL(timeout()), this, SLOT(aboutSaveScenarioChanges()));
+    connect(m_changesScheduler, &ScenarioChangesScheduler::captureRequested, this, &ScenarioManager::aboutSaveScenarioChanges);
 
     //
     // Настраиваем отслеживание изменений документа
     //
+    connect(m_scenario, &ScenarioDocument::textChanged, this, [this] {
+        m_isScenarioChanged = true;
+        m_hasUncapturedScenarioChanges = true;
+        m_changesScheduler->scheduleCapture();
+    });
     connect(m_scenario, &ScenarioDocument::textChanged, this, &ScenarioManager::scenarioChanged);
     connect(m_scenario, &ScenarioDocument::fixedScenesChanged, this, [this] (bool _fixed) {
         m_fixedScenes = _fixed;
@@ -1220,6 +1262,11 @@ void ScenarioManager::initConnections()
         }
         emit scriptFixedScenesChanged(_fixed);
     });
+    connect(m_scenarioDraft, &ScenarioDocument::textChanged, this, [this] {
+        m_isScenarioDraftChanged = true;
+        m_hasUncapturedScenarioDraftChanges = true;
+        m_changesScheduler->scheduleCapture();
+    });
     connect(m_scenarioDraft, &ScenarioDocument::textChanged, this, &ScenarioManager::scenarioChanged);
     connect(m_scenarioDraft, &ScenarioDocument::fixedScenesChanged, this, [this] (bool _fixed) {
         m_fixedScenesDraft = _fixed;
@@ -1227,9 +1274,17 @@ void ScenarioManager::initConnections()
             m_textEditManager->setFixed(m_fixedScenesDraft);
         }
     });
+    connect(m_cardsManager, &ScenarioCardsManager::cardsChanged, this, [this] {
+        m_isCardsSchemeChanged = true;
+        m_hasUncapturedCardsChanges = true;
+        m_changesScheduler->scheduleCapture();
+    });
     connect(m_cardsManager, &ScenarioCardsManager::cardsChanged, this, &ScenarioManager::scenarioChanged);
+    connect(m_sceneDescriptionManager, &ScenarioSceneDescriptionManager::titleChanged, this, &ScenarioManager::markWorkingScenarioChanged);
     connect(m_sceneDescriptionManager, &ScenarioSceneDescriptionManager::titleChanged, this, &ScenarioManager::scenarioChanged);
+    connect(m_sceneDescriptionManager, &ScenarioSceneDescriptionManager::descriptionChanged, this, &ScenarioManager::markWorkingScenarioChanged);
     connect(m_sceneDescriptionManager, &ScenarioSceneDescriptionManager::descriptionChanged, this, &ScenarioManager::scenarioChanged);
+    connect(m_textEditManager, &ScenarioTextEditManager::textChanged, this, &ScenarioManager::markWorkingScenarioChanged);
     connect(m_textEditManager, &ScenarioTextEditManager::textChanged, this, &ScenarioManager::scenarioChanged);
 }
 
@@ -1269,6 +1324,7 @@ void ScenarioManager::setWorkingMode(QObject* _sender)
             m_textEditManager->setScenarioDocument(nextTextDocument, workingModeIsDraft);
             m_textEditManager->setAdditionalCursors(additionalCursors);
             prevNavigatorManager->clearSelection();
+            m_cursorSceneIndex = QModelIndex();
 
             if (m_scenario->isAnySceneLocked() != m_scenarioDraft->isAnySceneLocked()) {
                 if (m_workModeIsDraft) {
@@ -1309,6 +1365,23 @@ void ScenarioManager::changeSceneNumbersLocking()
 
     if (result != QDialogButtonBox::Cancel) {
         workingScenario()->changeSceneNumbersLocking(allowedLock);
+        markWorkingScenarioChanged();
         emit scenarioChanged();
     }
 }
+
+void ScenarioManager::markWorkingScenarioChanged()
+{
+    //
+    // Изменения, не затрагивающие текст (цвета, штампы, номера сцен и т.п.), тоже должны
+    // попасть в патчи, иначе они не уйдут в облако и не будут участвовать в отмене/повторе
+    //
+    if (m_workModeIsDraft) {
+        m_isScenarioDraftChanged = true;
+        m_hasUncapturedScenarioDraftChanges = true;
+    } else {
+        m_isScenarioChanged = true;
+        m_hasUncapturedScenarioChanges = true;
+    }
+    m_changesScheduler->scheduleCapture();
+}
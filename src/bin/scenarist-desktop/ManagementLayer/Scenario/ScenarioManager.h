@@ -2,7 +2,6 @@
 #define SCENARIOMANAGER_H
 
 #include <QObject>
-#include <QTimer>
 #include <QModelIndex>
 
 class FlatButton;
@@ -20,10 +19,13 @@ namespace BusinessLogic {
 namespace ManagementLayer
 {
     class ScenarioCardsManager;
+    class ScenarioChangesScheduler;
     class ScenarioNavigatorManager;
     class ScenarioSceneDescriptionManager;
     class ScriptBookmarksManager;
     class ScriptDictionariesManager;
+    class ScriptDurationIndex;
+    class ScriptNamesIndex;
     class ScenarioTextEditManager;
 
 
@@ -71,14 +73,20 @@ namespace ManagementLayer
         void loadCurrentProject();
 
         /**
-         * @brief Сформировать карточки из сценария
+         * @brief Привести карточки в соответствие со сценарием
          */
         void rebuildCardsFromScript();
 
         /**
-         * @brief Запустить таймер сохранения изменений
+         * @brief Запустить отслеживание изменений
+         * @param _isRemote - работает ли пользователь с проектом из облака
          */
-        void startChangesHandling();
+        void startChangesHandling(bool _isRemote);
+
+        /**
+         * @brief Планировщик формирования патчей изменений
+         */
+        const ScenarioChangesScheduler* changesScheduler() const;
 
         /**
          * @brief Загрузить настройки текущего проекта
@@ -90,6 +98,12 @@ namespace ManagementLayer
          */
         void saveCurrentProject();
 
+        /**
+         * @brief Пометить сценарий, черновик и схему карточек как изменённые
+         * @note Используется, когда сохранение не удалось и при следующей попытке нужно записать всё заново
+         */
+        void markCurrentProjectChanged();
+
         /**
          * @brief Сохранить настройки текущего проекта
          */
@@ -407,6 +421,11 @@ namespace ManagementLayer
          */
         void changeSceneNumbersLocking();
 
+        /**
+         * @brief Пометить документ сценария в текущем режиме работы как изменённый
+         */
+        void markWorkingScenarioChanged();
+
     private:
         /**
          * @brief Представление сценария
@@ -446,6 +465,22 @@ namespace ManagementLayer
          */
         BusinessLogic::ScenarioDocument* m_scenarioDraft;
 
+        /**
+         * @brief Индексы упоминаний персонажей и локаций в сценарии и черновике
+         */
+        /** @{ */
+        ScriptNamesIndex* m_scenarioNamesIndex = nullptr;
+        ScriptNamesIndex* m_scenarioDraftNamesIndex = nullptr;
+        /** @} */
+
+        /**
+         * @brief Индексы хронометража блоков сценария и черновика
+         */
+        /** @{ */
+        ScriptDurationIndex* m_scenarioDurationIndex = nullptr;
+        ScriptDurationIndex* m_scenarioDraftDurationIndex = nullptr;
+        /** @} */
+
         /**
          * @brief Управляющий карточками
          */
@@ -494,6 +529,12 @@ namespace ManagementLayer
         bool m_fixedScenesDraft = false;
         /** @} */
 
+        /**
+         * @brief Сцена, название и описание которой показаны для текущей позиции курсора
+         * @note Сбрасывается при любом изменении моделей сценария и смене рабочего режима
+         */
+        QPersistentModelIndex m_cursorSceneIndex;
+
         /**
          * @brief Курсоры соавторов
          */
@@ -503,9 +544,27 @@ namespace ManagementLayer
         /** @} */
 
         /**
-         * @brief Таймер для сохранения изменений сценария
+         * @brief Планировщик формирования патчей изменений сценария
+         */
+        ScenarioChangesScheduler* m_changesScheduler = nullptr;
+
+        /**
+         * @brief Есть ли в сценарии, черновике и схеме карточек изменения, по которым ещё не сформированы патчи
+         */
+        /** @{ */
+        bool m_hasUncapturedScenarioChanges = false;
+        bool m_hasUncapturedScenarioDraftChanges = false;
+        bool m_hasUncapturedCardsChanges = false;
+        /** @} */
+
+        /**
+         * @brief Изменились ли сценарий, черновик и схема карточек с момента последнего сохранения
          */
-        QTimer m_saveChangesTimer;
+        /** @{ */
+        bool m_isScenarioChanged = false;
+        bool m_isScenarioDraftChanged = false;
+        bool m_isCardsSchemeChanged = false;
+        /** @} */
     };
 }
 
@@ -0,0 +1,57 @@
+#include "ScriptBlocksRange.h"
+
+#include <QTextBlock>
+#include <QTextDocument>
+
+using ManagementLayer::ScriptBlocksRange;
+
+
+ScriptBlocksRange::ScriptBlocksRange(const QTextDocument* _document, int _indexedBlocksCount,
+    int _position, int _charsAdded)
+{
+    //
+    // Изменённые блоки идут от блока с позицией изменения до блока с концом вставленного текста,
+    // а до изменения на их месте было столько же блоков за вычетом добавленных
+    //
+    m_firstBlockNumber = _document->findBlock(_position).blockNumber();
+    QTextBlock lastChangedBlock = _document->findBlock(_position + _charsAdded);
+    if (!lastChangedBlock.isValid()) {
+        lastChangedBlock = _document->lastBlock();
+    }
+    m_lastNewBlockNumber = lastChangedBlock.blockNumber();
+    m_lastOldBlockNumber = m_lastNewBlockNumber - (_document->blockCount() - _indexedBlocksCount);
+
+    m_isValid = m_firstBlockNumber >= 0
+                && m_lastOldBlockNumber >= m_firstBlockNumber
+                && m_lastOldBlockNumber < _indexedBlocksCount;
+}
+
+bool ScriptBlocksRange::isValid() const
+{
+    return m_isValid;
+}
+
+int ScriptBlocksRange::firstBlockNumber() const
+{
+    return m_firstBlockNumber;
+}
+
+int ScriptBlocksRange::lastOldBlockNumber() const
+{
+    return m_lastOldBlockNumber;
+}
+
+int ScriptBlocksRange::lastNewBlockNumber() const
+{
+    return m_lastNewBlockNumber;
+}
+
+int ScriptBlocksRange::oldBlocksCount() const
+{
+    return m_lastOldBlockNumber - m_firstBlockNumber + 1;
+}
+
+int ScriptBlocksRange::newBlocksCount() const
+{
+    return m_lastNewBlockNumber - m_firstBlockNumber + 1;
+}
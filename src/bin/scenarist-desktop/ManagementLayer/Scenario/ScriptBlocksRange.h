@@ -0,0 +1,89 @@
+#ifndef SCRIPTBLOCKSRANGE_H
+#define SCRIPTBLOCKSRANGE_H
+
+#include <QVector>
+
+class QTextDocument;
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Диапазон блоков документа, затронутых изменением текста
+     *
+     * Сопоставляет изменение документа с поблочным индексом, построенным до изменения:
+     * определяет, какие элементы индекса соответствуют изменённым блокам до изменения,
+     * и сколько блоков стало на их месте после него.
+     */
+    class ScriptBlocksRange
+    {
+    public:
+        /**
+         * @param _indexedBlocksCount - количество блоков в индексе, построенном до изменения
+         * @param _position, _charsAdded - параметры сигнала QTextDocument::contentsChange
+         */
+        ScriptBlocksRange(const QTextDocument* _document, int _indexedBlocksCount, int _position,
+            int _charsAdded);
+
+        /**
+         * @brief Удалось ли сопоставить изменение с индексом
+         * @note Если не удалось, индекс нужно перестроить целиком
+         */
+        bool isValid() const;
+
+        /**
+         * @brief Номер первого изменённого блока
+         */
+        int firstBlockNumber() const;
+
+        /**
+         * @brief Номер последнего изменённого блока до и после изменения
+         */
+        /** @{ */
+        int lastOldBlockNumber() const;
+        int lastNewBlockNumber() const;
+        /** @} */
+
+        /**
+         * @brief Количество изменённых блоков до и после изменения
+         */
+        /** @{ */
+        int oldBlocksCount() const;
+        int newBlocksCount() const;
+        /** @} */
+
+        /**
+         * @brief Скорректировать количество элементов индекса под новое количество блоков
+         * @note Добавленные элементы заполняются заданным значением, их нужно пересчитать
+         */
+        template <typename T>
+        void resize(QVector<T>& _blocks, const T& _value = T()) const {
+            if (newBlocksCount() > oldBlocksCount()) {
+                _blocks.insert(m_firstBlockNumber + oldBlocksCount(), newBlocksCount() - oldBlocksCount(), _value);
+            } else if (newBlocksCount() < oldBlocksCount()) {
+                _blocks.remove(m_firstBlockNumber + newBlocksCount(), oldBlocksCount() - newBlocksCount());
+            }
+        }
+
+    private:
+        /**
+         * @brief Номер первого изменённого блока
+         */
+        int m_firstBlockNumber = -1;
+
+        /**
+         * @brief Номер последнего изменённого блока до и после изменения
+         */
+        /** @{ */
+        int m_lastOldBlockNumber = -1;
+        int m_lastNewBlockNumber = -1;
+        /** @} */
+
+        /**
+         * @brief Удалось ли сопоставить изменение с индексом
+         */
+        bool m_isValid = false;
+    };
+}
+
+#endif // SCRIPTBLOCKSRANGE_H
@@ -0,0 +1,143 @@
+#include "ScriptDurationIndex.h"
+
+#include "ScriptBlocksRange.h"
+
+#include <BusinessLayer/Chronometry/ChronometerFacade.h>
+
+#include <QTextBlock>
+#include <QTextDocument>
+
+using ManagementLayer::ScriptBlocksRange;
+using ManagementLayer::ScriptDurationIndex;
+using BusinessLogic::ChronometerFacade;
+
+
+ScriptDurationIndex::ScriptDurationIndex(QTextDocument* _document) :
+    QObject(_document),
+    m_document(_document)
+{
+    Q_ASSERT(m_document);
+
+    connect(m_document, &QTextDocument::contentsChange, this, &ScriptDurationIndex::updateBlocks);
+}
+
+qreal ScriptDurationIndex::durationAtPosition(int _position)
+{
+    ensureIndexed();
+
+    const QTextBlock block = m_document->findBlock(_position);
+    if (!block.isValid()) {
+        return prefixDuration(m_durations.size());
+    }
+
+    return prefixDuration(block.blockNumber() + 1);
+}
+
+qreal ScriptDurationIndex::fullDuration()
+{
+    ensureIndexed();
+
+    return prefixDuration(m_durations.size());
+}
+
+void ScriptDurationIndex::invalidate()
+{
+    m_isIndexed = false;
+    m_durations.clear();
+    m_tree.clear();
+}
+
+void ScriptDurationIndex::updateBlocks(int _position, int _charsRemoved, int _charsAdded)
+{
+    Q_UNUSED(_charsRemoved);
+
+    //
+    // Пока индекс не востребован, не тратим время на его обновление
+    //
+    if (!m_isIndexed) {
+        return;
+    }
+
+    //
+    // Определим диапазон изменённых блоков до и после изменения, а если изменение
+    // не удаётся сопоставить с индексом, то перестроим его при следующем обращении
+    //
+    const ScriptBlocksRange range(m_document, m_durations.size(), _position, _charsAdded);
+    if (!range.isValid()) {
+        invalidate();
+        return;
+    }
+
+    //
+    // Если количество блоков не изменилось, то обновляем только изменённые элементы дерева...
+    //
+    QTextBlock block = m_document->findBlockByNumber(range.firstBlockNumber());
+    if (range.newBlocksCount() == range.oldBlocksCount()) {
+        for (int blockNumber = range.firstBlockNumber(); blockNumber <= range.lastNewBlockNumber(); ++blockNumber) {
+            setBlockDuration(blockNumber, ChronometerFacade::calculate(block));
+            block = block.next();
+        }
+        return;
+    }
+
+    //
+    // ... а если изменилось, то сдвигаем хронометраж блоков и перестраиваем дерево,
+    //     пересчитывая хронометраж только изменённых блоков
+    //
+    range.resize(m_durations, qreal(0));
+    for (int blockNumber = range.firstBlockNumber(); blockNumber <= range.lastNewBlockNumber(); ++blockNumber) {
+        m_durations[blockNumber] = ChronometerFacade::calculate(block);
+        block = block.next();
+    }
+    buildTree();
+}
+
+void ScriptDurationIndex::ensureIndexed()
+{
+    if (m_isIndexed) {
+        return;
+    }
+
+    m_durations.clear();
+    m_durations.reserve(m_document->blockCount());
+    for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+        m_durations.append(ChronometerFacade::calculate(block));
+    }
+    buildTree();
+    m_isIndexed = true;
+}
+
+void ScriptDurationIndex::buildTree()
+{
+    const int size = m_durations.size();
+    m_tree.fill(0, size + 1);
+    for (int index = 1; index <= size; ++index) {
+        m_tree[index] += m_durations.at(index - 1);
+        const int parent = index + (index & -index);
+        if (parent <= size) {
+            m_tree[parent] += m_tree.at(index);
+        }
+    }
+}
+
+void ScriptDurationIndex::setBlockDuration(int _blockNumber, qreal _duration)
+{
+    const qreal delta = _duration - m_durations.at(_blockNumber);
+    if (qFuzzyIsNull(delta)) {
+        return;
+    }
+
+    m_durations[_blockNumber] = _duration;
+    for (int index = _blockNumber + 1; index < m_tree.size(); index += index & -index) {
+        m_tree[index] += delta;
+    }
+}
+
+qreal ScriptDurationIndex::prefixDuration(int _count) const
+{
+    qreal duration = 0;
+    for (int index = qMin(_count, m_tree.size() - 1); index > 0; index -= index & -index) {
+        duration += m_tree.at(index);
+    }
+    return duration;
+}
@@ -0,0 +1,93 @@
+#ifndef SCRIPTDURATIONINDEX_H
+#define SCRIPTDURATIONINDEX_H
+
+#include <QObject>
+#include <QVector>
+
+class QTextDocument;
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Индекс хронометража блоков документа сценария
+     *
+     * Хранит хронометраж каждого блока документа в дереве Фенвика, что позволяет
+     * получать хронометраж от начала документа до любой позиции за логарифмическое время.
+     * При редактировании текста пересчитывается хронометраж только изменённых блоков.
+     *
+     * @note Индекс принадлежит документу, поэтому его можно получить через
+     *       QObject::findChild<ScriptDurationIndex*>() у документа
+     */
+    class ScriptDurationIndex : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ScriptDurationIndex(QTextDocument* _document);
+
+        /**
+         * @brief Хронометраж от начала документа до блока с заданной позицией включительно
+         */
+        qreal durationAtPosition(int _position);
+
+        /**
+         * @brief Хронометраж всего документа
+         */
+        qreal fullDuration();
+
+        /**
+         * @brief Сбросить индекс, например, после смены настроек хронометража
+         */
+        void invalidate();
+
+    private:
+        /**
+         * @brief Обновить индекс для изменённого фрагмента документа
+         */
+        void updateBlocks(int _position, int _charsRemoved, int _charsAdded);
+
+        /**
+         * @brief Перестроить индекс, если он не актуален
+         */
+        void ensureIndexed();
+
+        /**
+         * @brief Построить дерево по текущему хронометражу блоков
+         */
+        void buildTree();
+
+        /**
+         * @brief Изменить хронометраж блока с заданным номером
+         */
+        void setBlockDuration(int _blockNumber, qreal _duration);
+
+        /**
+         * @brief Сумма хронометража первых _count блоков
+         */
+        qreal prefixDuration(int _count) const;
+
+    private:
+        /**
+         * @brief Документ
+         */
+        QTextDocument* m_document = nullptr;
+
+        /**
+         * @brief Хронометраж блоков документа в порядке их следования
+         */
+        QVector<qreal> m_durations;
+
+        /**
+         * @brief Дерево Фенвика по хронометражу блоков (нумерация элементов с единицы)
+         */
+        QVector<qreal> m_tree;
+
+        /**
+         * @brief Актуален ли индекс
+         */
+        bool m_isIndexed = false;
+    };
+}
+
+#endif // SCRIPTDURATIONINDEX_H
@@ -0,0 +1,255 @@
+#include "ScriptNamesIndex.h"
+
+#include "ScriptBlocksRange.h"
+
+#include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextBlockParsers.h>
+
+#include <3rd_party/Helpers/TextEditHelper.h>
+
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+
+using ManagementLayer::ScriptBlocksRange;
+using ManagementLayer::ScriptNamesIndex;
+using BusinessLogic::ScenarioBlockStyle;
+
+namespace {
+    /**
+     * @brief Может ли символ ограничивать имя персонажа в блоке участников сцены
+     */
+    static bool isSceneCharactersDelimiter(const QChar& _character) {
+        return _character == ' ' || _character == ',';
+    }
+
+    /**
+     * @brief Может ли символ ограничивать имя персонажа, или название локации в остальных блоках
+     */
+    static bool isWordDelimiter(const QChar& _character) {
+        return !_character.isLetterOrNumber();
+    }
+}
+
+
+ScriptNamesIndex::ScriptNamesIndex(QTextDocument* _document) :
+    QObject(_document),
+    m_document(_document)
+{
+    Q_ASSERT(m_document);
+
+    connect(m_document, &QTextDocument::contentsChange, this, &ScriptNamesIndex::updateBlocks);
+}
+
+QSet<QString> ScriptNamesIndex::characters()
+{
+    ensureIndexed();
+
+    return QSet<QString>::fromList(m_charactersCounts.keys());
+}
+
+QSet<QString> ScriptNamesIndex::locations()
+{
+    ensureIndexed();
+
+    return QSet<QString>::fromList(m_locationsCounts.keys());
+}
+
+void ScriptNamesIndex::renameCharacter(const QString& _oldName, const QString& _newName)
+{
+    ensureIndexed();
+
+    QVector<int> blocksNumbers;
+    for (int blockNumber = 0; blockNumber < m_blocks.size(); ++blockNumber) {
+        if (m_blocks.at(blockNumber).characters.contains(_oldName)) {
+            blocksNumbers.append(blockNumber);
+        }
+    }
+    replaceName(blocksNumbers, _oldName, _newName);
+}
+
+void ScriptNamesIndex::renameLocation(const QString& _oldName, const QString& _newName)
+{
+    ensureIndexed();
+
+    QVector<int> blocksNumbers;
+    for (int blockNumber = 0; blockNumber < m_blocks.size(); ++blockNumber) {
+        if (m_blocks.at(blockNumber).location == _oldName) {
+            blocksNumbers.append(blockNumber);
+        }
+    }
+    replaceName(blocksNumbers, _oldName, _newName);
+}
+
+ScriptNamesIndex::BlockNames ScriptNamesIndex::blockNames(const QTextBlock& _block)
+{
+    BlockNames names;
+    names.type = ScenarioBlockStyle::forBlock(_block);
+    switch (names.type) {
+        case ScenarioBlockStyle::Character: {
+            const QString name =
+                    TextEditHelper::smartToUpper(BusinessLogic::CharacterParser::name(_block.text()));
+            if (!name.isEmpty()) {
+                names.characters.append(name);
+            }
+            break;
+        }
+
+        case ScenarioBlockStyle::SceneCharacters: {
+            foreach (const QString& character, BusinessLogic::SceneCharactersParser::characters(_block.text())) {
+                const QString name = TextEditHelper::smartToUpper(character);
+                if (!name.isEmpty()) {
+                    names.characters.append(name);
+                }
+            }
+            break;
+        }
+
+        case ScenarioBlockStyle::SceneHeading: {
+            names.location =
+                    TextEditHelper::smartToUpper(BusinessLogic::SceneHeadingParser::locationName(_block.text()));
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+
+    return names;
+}
+
+void ScriptNamesIndex::countBlockNames(const ScriptNamesIndex::BlockNames& _names, int _delta)
+{
+    const auto count = [_delta] (QHash<QString, int>& _counts, const QString& _name) {
+        const int newCount = _counts.value(_name) + _delta;
+        if (newCount > 0) {
+            _counts.insert(_name, newCount);
+        } else {
+            _counts.remove(_name);
+        }
+    };
+
+    foreach (const QString& character, _names.characters) {
+        count(m_charactersCounts, character);
+    }
+    if (!_names.location.isEmpty()) {
+        count(m_locationsCounts, _names.location);
+    }
+}
+
+void ScriptNamesIndex::updateBlocks(int _position, int _charsRemoved, int _charsAdded)
+{
+    Q_UNUSED(_charsRemoved);
+
+    //
+    // Пока индекс не востребован, не тратим время на его обновление
+    //
+    if (!m_isIndexed) {
+        return;
+    }
+
+    //
+    // Определим диапазон изменённых блоков до и после изменения, а если изменение
+    // не удаётся сопоставить с индексом, то перестроим его при следующем обращении
+    //
+    const ScriptBlocksRange range(m_document, m_blocks.size(), _position, _charsAdded);
+    if (!range.isValid()) {
+        m_isIndexed = false;
+        m_blocks.clear();
+        m_charactersCounts.clear();
+        m_locationsCounts.clear();
+        return;
+    }
+
+    //
+    // Исключаем из счётчиков имена блоков, которые были изменены
+    //
+    for (int blockNumber = range.firstBlockNumber(); blockNumber <= range.lastOldBlockNumber(); ++blockNumber) {
+        countBlockNames(m_blocks.at(blockNumber), -1);
+    }
+
+    //
+    // Корректируем количество элементов индекса под новое количество блоков
+    //
+    range.resize(m_blocks);
+
+    //
+    // ... и перепроверяем изменённые блоки
+    //
+    QTextBlock block = m_document->findBlockByNumber(range.firstBlockNumber());
+    for (int blockNumber = range.firstBlockNumber(); blockNumber <= range.lastNewBlockNumber(); ++blockNumber) {
+        m_blocks[blockNumber] = blockNames(block);
+        countBlockNames(m_blocks.at(blockNumber), 1);
+        block = block.next();
+    }
+}
+
+void ScriptNamesIndex::ensureIndexed()
+{
+    if (m_isIndexed) {
+        return;
+    }
+
+    m_blocks.clear();
+    m_charactersCounts.clear();
+    m_locationsCounts.clear();
+    m_blocks.reserve(m_document->blockCount());
+    for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+        m_blocks.append(blockNames(block));
+        countBlockNames(m_blocks.last(), 1);
+    }
+    m_isIndexed = true;
+}
+
+void ScriptNamesIndex::replaceName(const QVector<int>& _blocksNumbers, const QString& _oldName,
+    const QString& _newName)
+{
+    if (_blocksNumbers.isEmpty()) {
+        return;
+    }
+
+    QTextCursor cursor(m_document);
+    cursor.beginEditBlock();
+    //
+    // Идём с конца, чтобы замены не сбивали позиции ещё не обработанных вхождений
+    //
+    for (int index = _blocksNumbers.size() - 1; index >= 0; --index) {
+        const int blockNumber = _blocksNumbers.at(index);
+        const QTextBlock block = m_document->findBlockByNumber(blockNumber);
+        const QString blockText = block.text();
+
+        //
+        // В участниках сцены заменяем все вхождения имени, ограниченные пробелами и запятыми,
+        // а в остальных блоках только само имя персонажа, или название локации
+        //
+        const bool isSceneCharacters = m_blocks.at(blockNumber).type == ScenarioBlockStyle::SceneCharacters;
+        bool (*isDelimiter)(const QChar&) =
+                isSceneCharacters ? &isSceneCharactersDelimiter : &isWordDelimiter;
+
+        QVector<int> positions;
+        int position = blockText.indexOf(_oldName, 0, Qt::CaseInsensitive);
+        while (position != -1) {
+            //
+            // Выделенным должно быть именно имя, а не составная часть другого имени
+            //
+            const int endPosition = position + _oldName.length();
+            const bool atLeftAllOk = position == 0 || isDelimiter(blockText.at(position - 1));
+            const bool atRightAllOk = endPosition == blockText.length() || isDelimiter(blockText.at(endPosition));
+            if (atLeftAllOk && atRightAllOk) {
+                positions.append(position);
+                if (!isSceneCharacters) {
+                    break;
+                }
+            }
+            position = blockText.indexOf(_oldName, position + 1, Qt::CaseInsensitive);
+        }
+
+        for (int positionIndex = positions.size() - 1; positionIndex >= 0; --positionIndex) {
+            cursor.setPosition(block.position() + positions.at(positionIndex));
+            cursor.setPosition(cursor.position() + _oldName.length(), QTextCursor::KeepAnchor);
+            cursor.insertText(_newName);
+        }
+    }
+    cursor.endEditBlock();
+}
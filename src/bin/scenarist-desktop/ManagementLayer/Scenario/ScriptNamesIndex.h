@@ -0,0 +1,126 @@
+#ifndef SCRIPTNAMESINDEX_H
+#define SCRIPTNAMESINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class QTextBlock;
+class QTextDocument;
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Индекс упоминаний персонажей и локаций в блоках документа сценария
+     *
+     * Хранит для каждого блока документа найденные в нём имена персонажей и название локации,
+     * а также количество упоминаний каждого имени в документе. При редактировании текста
+     * перепроверяются только изменённые блоки.
+     *
+     * @note Индекс принадлежит документу, поэтому его можно получить через
+     *       QObject::findChild<ScriptNamesIndex*>() у документа
+     */
+    class ScriptNamesIndex : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ScriptNamesIndex(QTextDocument* _document);
+
+        /**
+         * @brief Персонажи, упоминаемые в документе
+         */
+        QSet<QString> characters();
+
+        /**
+         * @brief Локации, упоминаемые в документе
+         */
+        QSet<QString> locations();
+
+        /**
+         * @brief Заменить имя персонажа в тексте документа
+         */
+        void renameCharacter(const QString& _oldName, const QString& _newName);
+
+        /**
+         * @brief Заменить название локации в тексте документа
+         */
+        void renameLocation(const QString& _oldName, const QString& _newName);
+
+    private:
+        /**
+         * @brief Имена, упоминаемые в блоке
+         */
+        struct BlockNames {
+            /**
+             * @brief Тип блока
+             */
+            int type = 0;
+
+            /**
+             * @brief Персонажи
+             */
+            QStringList characters;
+
+            /**
+             * @brief Локация
+             */
+            QString location;
+        };
+
+        /**
+         * @brief Определить имена, упоминаемые в блоке
+         */
+        static BlockNames blockNames(const QTextBlock& _block);
+
+        /**
+         * @brief Учесть имена блока в счётчиках упоминаний
+         * @param _delta - 1, если блок добавляется в индекс, -1, если удаляется из него
+         */
+        void countBlockNames(const BlockNames& _names, int _delta);
+
+        /**
+         * @brief Обновить индекс для изменённого фрагмента документа
+         */
+        void updateBlocks(int _position, int _charsRemoved, int _charsAdded);
+
+        /**
+         * @brief Перестроить индекс, если он не актуален
+         */
+        void ensureIndexed();
+
+        /**
+         * @brief Заменить имя в блоках с заданными номерами одним действием редактирования
+         */
+        void replaceName(const QVector<int>& _blocksNumbers, const QString& _oldName, const QString& _newName);
+
+    private:
+        /**
+         * @brief Документ
+         */
+        QTextDocument* m_document = nullptr;
+
+        /**
+         * @brief Имена в блоках документа в порядке их следования
+         */
+        QVector<BlockNames> m_blocks;
+
+        /**
+         * @brief Количество упоминаний персонажей и локаций в документе
+         */
+        /** @{ */
+        QHash<QString, int> m_charactersCounts;
+        QHash<QString, int> m_locationsCounts;
+        /** @} */
+
+        /**
+         * @brief Актуален ли индекс
+         */
+        bool m_isIndexed = false;
+    };
+}
+
+#endif // SCRIPTNAMESINDEX_H
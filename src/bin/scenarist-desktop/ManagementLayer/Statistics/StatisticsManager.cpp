@@ -30,6 +30,10 @@ StatisticsManager::StatisticsManager(QObject* _parent, QWidget* _parentWidget) :
     initConnections();
 }
 
+StatisticsManager::~StatisticsManager()
+{
+}
+
 QWidget* StatisticsManager::view() const
 {
     return m_view;
@@ -42,6 +46,7 @@ void StatisticsManager::loadCurrentProject()
     //
     setExportedScenario(0);
     m_needUpdateScenario = true;
+    resetCache();
     m_view->setReport(QString::null);
 
     //
@@ -53,6 +58,13 @@ void StatisticsManager::loadCurrentProject()
 void StatisticsManager::scenarioTextChanged()
 {
     m_needUpdateScenario = true;
+    resetCache();
+}
+
+void StatisticsManager::resetCache()
+{
+    m_reportsCache.clear();
+    m_plotsCache.clear();
 }
 
 void StatisticsManager::setExportedScenario(QTextDocument* _scenario)
@@ -77,12 +89,21 @@ void StatisticsManager::aboutMakeReport(const BusinessLogic::StatisticsParameter
         emit needNewExportedScenario();
     }
 
+    //
+    // Пока не изменились текст сценария и параметры, повторно запрошенные отчёты и графики
+    // берём из кэша
+    //
+    const CacheKey key = cacheKey(_parameters);
+
     switch (_parameters.type) {
         case BusinessLogic::StatisticsParameters::Report: {
             //
             // Формируем отчёт
             //
-            const QString reportHtml = BusinessLogic::StatisticsFacade::makeReport(m_exportedScenario, _parameters);
+            if (!m_reportsCache.contains(key)) {
+                m_reportsCache.insert(key, BusinessLogic::StatisticsFacade::makeReport(m_exportedScenario, _parameters));
+            }
+            const QString reportHtml = m_reportsCache.value(key);
 
             //
             // Устанавливаем отчёт в форму
@@ -96,7 +117,10 @@ void StatisticsManager::aboutMakeReport(const BusinessLogic::StatisticsParameter
             //
             // Формируем данные
             //
-            BusinessLogic::Plot plot = BusinessLogic::StatisticsFacade::makePlot(m_exportedScenario, _parameters);
+            if (!m_plotsCache.contains(key)) {
+                m_plotsCache.insert(key, BusinessLogic::StatisticsFacade::makePlot(m_exportedScenario, _parameters));
+            }
+            const BusinessLogic::Plot plot = m_plotsCache.value(key);
 
             //
             // Рисуем график по данным
@@ -114,6 +138,18 @@ void StatisticsManager::aboutMakeReport(const BusinessLogic::StatisticsParameter
     m_view->hideProgress();
 }
 
+StatisticsManager::CacheKey StatisticsManager::cacheKey(const BusinessLogic::StatisticsParameters& _parameters)
+{
+    //
+    // Остальные параметры в ключ не входят, т.к. при их изменении кэш сбрасывается целиком
+    //
+    const int subtype =
+            _parameters.type == BusinessLogic::StatisticsParameters::Report
+            ? _parameters.reportType
+            : _parameters.plotType;
+    return qMakePair(static_cast<int>(_parameters.type), subtype);
+}
+
 void StatisticsManager::initView()
 {
 
@@ -121,6 +157,7 @@ void StatisticsManager::initView()
 
 void StatisticsManager::initConnections()
 {
+    connect(m_view, &StatisticsView::settingsChanged, this, &StatisticsManager::resetCache);
     connect(m_view, &StatisticsView::makeReportRequested, this, &StatisticsManager::aboutMakeReport);
     connect(m_view, &StatisticsView::linkActivated, this, &StatisticsManager::linkActivated);
 }
@@ -1,7 +1,9 @@
 #ifndef STATISTICSMANAGER_H
 #define STATISTICSMANAGER_H
 
+#include <QHash>
 #include <QObject>
+#include <QPair>
 
 class QTextDocument;
 
@@ -11,6 +13,7 @@ namespace UserInterface {
 
 namespace BusinessLogic {
 	class StatisticsParameters;
+	class Plot;
 }
 
 
@@ -25,6 +28,7 @@ namespace ManagementLayer
 
 	public:
 		explicit StatisticsManager(QObject* _parent, QWidget* _parentWidget);
+		~StatisticsManager();
 
 		QWidget* view() const;
 
@@ -38,6 +42,12 @@ namespace ManagementLayer
 		 */
 		void scenarioTextChanged();
 
+		/**
+		 * @brief Сбросить построенные отчёты и графики, например, после смены настроек хронометража,
+		 *        или параметров отчётов
+		 */
+		void resetCache();
+
 	public slots:
 		/**
 		 * @brief Установить экспортированный сценарий, по которому будет считаться статистика
@@ -62,6 +72,16 @@ namespace ManagementLayer
 		void aboutMakeReport(const BusinessLogic::StatisticsParameters& _parameters);
 
 	private:
+		/**
+		 * @brief Ключ кэша - тип статистики (отчёт, или график) и тип отчёта, или графика
+		 */
+		typedef QPair<int, int> CacheKey;
+
+		/**
+		 * @brief Ключ кэша для отчёта, или графика с заданными параметрами
+		 */
+		static CacheKey cacheKey(const BusinessLogic::StatisticsParameters& _parameters);
+
 		/**
 		 * @brief Настроить представление
 		 */
@@ -87,6 +107,14 @@ namespace ManagementLayer
 		 * @brief Флаг обозначающий необходимость обновить текст сценария перед построением отчёта
 		 */
 		bool m_needUpdateScenario;
+
+		/**
+		 * @brief Отчёты и графики, построенные по текущему тексту сценария и текущим параметрам
+		 */
+		/** @{ */
+		QHash<CacheKey, QString> m_reportsCache;
+		QHash<CacheKey, BusinessLogic::Plot> m_plotsCache;
+		/** @} */
 	};
 }
 
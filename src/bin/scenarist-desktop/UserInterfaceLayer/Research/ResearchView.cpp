@@ -186,6 +186,15 @@ QModelIndex ResearchView::currentResearchIndex() const
     return currentResearchIndex;
 }
 
+QSize ResearchView::imagePreviewSize() const
+{
+    //
+    // Берём размер контейнера редакторов, т.к. он размещён всегда, а редактор изображения
+    // может быть ещё не показан
+    //
+    return m_ui->researchDataEditsContainer->size() * devicePixelRatio();
+}
+
 void ResearchView::selectItem(const QModelIndex& _index)
 {
     m_ui->researchNavigator->expand(_index.parent());
@@ -408,6 +417,16 @@ void ResearchView::editImagesGallery(const QString& _name, const QList<QPixmap>&
     setAddVisible(false);
 }
 
+void ResearchView::addImagesGalleryImage(const QPixmap& _image)
+{
+    //
+    // Изображение добавляется не пользователем, поэтому не уведомляем об изменении галереи
+    //
+    disconnect(m_ui->imagesGalleryPane, &ImagesPane::imageAdded, this, &ResearchView::imagesGalleryImageAdded);
+    m_ui->imagesGalleryPane->addImage(_image);
+    connect(m_ui->imagesGalleryPane, &ImagesPane::imageAdded, this, &ResearchView::imagesGalleryImageAdded);
+}
+
 void ResearchView::editImage(const QString& _name, const QPixmap& _image)
 {
     m_ui->researchDataEditsContainer->setCurrentWidget(m_ui->imageEdit);
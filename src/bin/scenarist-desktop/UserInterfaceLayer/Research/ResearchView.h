@@ -50,6 +50,11 @@ namespace UserInterface
          */
         QModelIndex currentResearchIndex() const;
 
+        /**
+         * @brief Размер области предпросмотра изображения в пикселях экрана
+         */
+        QSize imagePreviewSize() const;
+
         /**
          * @brief Выделить элемент с заданным индексом
          */
@@ -122,6 +127,11 @@ namespace UserInterface
          */
         void editImagesGallery(const QString& _name, const QList<QPixmap>& _images);
 
+        /**
+         * @brief Добавить изображение в конец редактируемой галереи
+         */
+        void addImagesGalleryImage(const QPixmap& _image);
+
         /**
          * @brief Включить режим редактирования изображения
          */
@@ -9,6 +9,8 @@
 #include <3rd_party/Widgets/CardsEdit/CardsView.h>
 #include <3rd_party/Widgets/FlatButton/FlatButton.h>
 
+#include <QAbstractScrollArea>
+#include <QEvent>
 #include <QFileInfo>
 #include <QFileDialog>
 #include <QHBoxLayout>
@@ -16,6 +18,7 @@
 #include <QMenu>
 #include <QShortcut>
 #include <QStandardPaths>
+#include <QTimer>
 #include <QVariant>
 #include <QWidgetAction>
 
@@ -27,6 +30,16 @@ namespace {
      * @brief Ключ настроек для доступа к папке сохранения картинки карточек
      */
     const QString CARDS_FOLDER_KEY = "cards/save-folder";
+
+    /**
+     * @brief Переменная окружения, при наличии которой показывается время отрисовки кадров доски
+     */
+    const char* FRAME_TIME_ENVIRONMENT_VARIABLE = "SCENARIST_CARDS_FRAME_TIME";
+
+    /**
+     * @brief Интервал обновления статистики времени отрисовки кадров, мс
+     */
+    const int FRAME_STATISTICS_INTERVAL = 500;
 }
 
 
@@ -150,8 +163,61 @@ void ScenarioCardsView::setCommentOnly(bool _isCommentOnly)
     }
 }
 
+bool ScenarioCardsView::eventFilter(QObject* _watched, QEvent* _event)
+{
+    //
+    // Замеряем время отрисовки кадра доски: от получения события отрисовки,
+    // до возврата в цикл обработки событий после неё
+    //
+    if (m_frameTimeInfo != nullptr
+        && _event->type() == QEvent::Paint
+        && !m_frameTimer.isValid()) {
+        m_frameTimer.start();
+        QTimer::singleShot(0, this, [this] {
+            const qint64 frameTime = m_frameTimer.nsecsElapsed();
+            m_frameTimer.invalidate();
+
+            ++m_framesCount;
+            m_framesTime += frameTime;
+            m_maxFrameTime = qMax(m_maxFrameTime, frameTime);
+            if (!m_frameStatisticsTimer.isValid()) {
+                m_frameStatisticsTimer.start();
+            } else if (m_frameStatisticsTimer.hasExpired(FRAME_STATISTICS_INTERVAL)) {
+                const qreal nsecsInMsec = 1000000.;
+                m_frameTimeInfo->setText(
+                    QString("%1: %2 | %3 ms")
+                    .arg(tr("Frame"))
+                    .arg(m_framesTime / m_framesCount / nsecsInMsec, 0, 'f', 1)
+                    .arg(m_maxFrameTime / nsecsInMsec, 0, 'f', 1));
+                m_framesCount = 0;
+                m_framesTime = 0;
+                m_maxFrameTime = 0;
+                m_frameStatisticsTimer.restart();
+            }
+        });
+    }
+
+    return QWidget::eventFilter(_watched, _event);
+}
+
+void ScenarioCardsView::scheduleResortCards()
+{
+    //
+    // При перетаскивании ползунков параметры меняются очень часто,
+    // поэтому упорядочиваем карточки не чаще одного раза за проход цикла событий
+    //
+    if (m_isResortScheduled) {
+        return;
+    }
+
+    m_isResortScheduled = true;
+    QTimer::singleShot(0, this, &ScenarioCardsView::resortCards);
+}
+
 void ScenarioCardsView::resortCards()
 {
+    m_isResortScheduled = false;
+
     //
     // Вычисляем размер карточки
     //
@@ -171,22 +237,41 @@ void ScenarioCardsView::resortCards()
     const qreal cardWidth = (qreal)m_resizer->cardSize() * widthDivider;
     const qreal cardHeight = (qreal)m_resizer->cardSize() * heightDivider;
     const QSizeF cardSize(cardWidth, cardHeight);
-    m_cards->setCardsSize(cardSize);
+
+    //
+    // Каждый из параметров приводит к перекомпоновке всей доски,
+    // поэтому передаём в редактор только те, которые действительно изменились
+    //
+    const bool isFirstResort = !m_isCardsResorted;
+    m_isCardsResorted = true;
+    if (isFirstResort || m_cardsSize != cardSize) {
+        m_cardsSize = cardSize;
+        m_cards->setCardsSize(cardSize);
+    }
 
     //
     // Расстояние между карточками
     //
-    m_cards->setCardsDistance(m_resizer->distance());
+    if (isFirstResort || m_cardsDistance != m_resizer->distance()) {
+        m_cardsDistance = m_resizer->distance();
+        m_cards->setCardsDistance(m_cardsDistance);
+    }
 
     //
     // Использовать компановку по строкам
     //
-    m_cards->setOrderByRows(m_resizer->useRowsLayout());
+    if (isFirstResort || m_isOrderByRows != m_resizer->useRowsLayout()) {
+        m_isOrderByRows = m_resizer->useRowsLayout();
+        m_cards->setOrderByRows(m_isOrderByRows);
+    }
 
     //
     // Количество карточек в строке
     //
-    m_cards->setCardsInRow(m_resizer->cardsInRow());
+    if (isFirstResort || m_cardsInRow != m_resizer->cardsInRow()) {
+        m_cardsInRow = m_resizer->cardsInRow();
+        m_cards->setCardsInRow(m_cardsInRow);
+    }
 }
 
 void ScenarioCardsView::initView(bool _isDraft)
@@ -249,6 +334,23 @@ void ScenarioCardsView::initView(bool _isDraft)
     toolbarLayout->addWidget(m_toolbarSpacer);
     toolbarLayout->addWidget(m_fullscreen);
 
+    //
+    // Время отрисовки кадров доски показываем только по запросу, для замеров производительности
+    //
+    if (qEnvironmentVariableIsSet(FRAME_TIME_ENVIRONMENT_VARIABLE)) {
+        QAbstractScrollArea* cardsArea = qobject_cast<QAbstractScrollArea*>(m_cards);
+        if (cardsArea == nullptr) {
+            cardsArea = m_cards->findChild<QAbstractScrollArea*>();
+        }
+        if (cardsArea != nullptr) {
+            m_frameTimeInfo = new QLabel(toolbar);
+            m_frameTimeInfo->setProperty("inTopPanel", true);
+            m_frameTimeInfo->setProperty("topPanelTopBordered", true);
+            toolbarLayout->insertWidget(toolbarLayout->indexOf(m_toolbarSpacer) + 1, m_frameTimeInfo);
+            cardsArea->viewport()->installEventFilter(this);
+        }
+    }
+
     QVBoxLayout* layout = new QVBoxLayout;
     layout->setContentsMargins(QMargins());
     layout->setSpacing(0);
@@ -296,7 +398,7 @@ void ScenarioCardsView::initConnections()
     connect(m_cards, &CardsView::cardTypeChanged, this, &ScenarioCardsView::cardTypeChanged);
 
     connect(m_sort, &FlatButton::clicked, m_sort, &FlatButton::showMenu);
-    connect(m_resizer, &CardsResizer::parametersChanged, this, &ScenarioCardsView::resortCards);
+    connect(m_resizer, &CardsResizer::parametersChanged, this, &ScenarioCardsView::scheduleResortCards);
 
     connect(m_save, &FlatButton::clicked, this, &ScenarioCardsView::saveToImage);
 
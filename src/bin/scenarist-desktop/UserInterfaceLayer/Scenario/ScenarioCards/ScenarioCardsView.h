@@ -1,6 +1,7 @@
 #ifndef SCENARIOCARDSVIEW_H
 #define SCENARIOCARDSVIEW_H
 
+#include <QElapsedTimer>
 #include <QWidget>
 
 class CardsView;
@@ -184,7 +185,18 @@ namespace UserInterface {
          */
         void cardsChanged();
 
+    protected:
+        /**
+         * @brief Переопределяется для замера времени отрисовки кадров доски
+         */
+        bool eventFilter(QObject* _watched, QEvent* _event) override;
+
     private:
+        /**
+         * @brief Запланировать упорядочивание карточек по сетке
+         */
+        void scheduleResortCards();
+
         /**
          * @brief Упорядочить карточки по сетке
          */
@@ -266,6 +278,39 @@ namespace UserInterface {
          * @brief Позиция вставки новой карточки
          */
         QPointF m_newCardPosition;
+
+        /**
+         * @brief Запланировано ли упорядочивание карточек
+         */
+        bool m_isResortScheduled = false;
+
+        /**
+         * @brief Параметры упорядочивания, переданные в редактор карточек
+         */
+        /** @{ */
+        bool m_isCardsResorted = false;
+        QSizeF m_cardsSize;
+        int m_cardsDistance = 0;
+        bool m_isOrderByRows = false;
+        int m_cardsInRow = 0;
+        /** @} */
+
+        /**
+         * @brief Метка со временем отрисовки кадров доски
+         * @note Создаётся только если замер времени отрисовки включён
+         */
+        QLabel* m_frameTimeInfo = nullptr;
+
+        /**
+         * @brief Замер времени отрисовки текущего кадра и статистика за интервал
+         */
+        /** @{ */
+        QElapsedTimer m_frameTimer;
+        QElapsedTimer m_frameStatisticsTimer;
+        int m_framesCount = 0;
+        qint64 m_framesTime = 0;
+        qint64 m_maxFrameTime = 0;
+        /** @} */
     };
 }
 
@@ -493,6 +493,7 @@ void StatisticsView::initConnections()
     connect(m_statisticSettings, &StatisticsSettings::backPressed, [this] {
         WAF::StackedWidgetAnimation::slide(m_navigation, m_navigation->widget(0), WAF::FromLeftToRight);
     });
+    connect(m_statisticSettings, &StatisticsSettings::settingsChanged, this, &StatisticsView::settingsChanged);
     connect(m_statisticSettings, &StatisticsSettings::settingsChanged, this, &StatisticsView::makeReport);
 
     connect(m_print, &FlatButton::clicked, this, &StatisticsView::printReport);
@@ -64,6 +64,11 @@ namespace UserInterface
          */
         void makeReportRequested(const BusinessLogic::StatisticsParameters& _parameters);
 
+        /**
+         * @brief Изменились параметры отчётов и графиков
+         */
+        void settingsChanged();
+
         /**
          * @brief В отчёте активирована ссылка
          */
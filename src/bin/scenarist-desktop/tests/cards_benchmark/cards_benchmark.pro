@@ -0,0 +1,50 @@
+#
+# Замер скорости обновления карточек при добавлении большого количества сцен
+#
+# Собирается из исходников приложения: подключаем проект приложения, переводим относительные
+# пути к его файлам на каталог приложения и подменяем точку входа
+#
+APP_DIR = $$PWD/../../..
+
+include($$APP_DIR/scenarist-desktop.pro)
+
+TARGET = cards_benchmark
+
+CONFIG += console
+CONFIG -= app_bundle
+
+#
+# Конфигурируем расположение файлов сборки
+#
+CONFIG(debug, debug|release) {
+    DESTDIR = $$APP_DIR/../../build/Debug/tests/cards_benchmark
+} else {
+    DESTDIR = $$APP_DIR/../../build/Release/tests/cards_benchmark
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
+RCC_DIR = $$DESTDIR/.qrc
+UI_DIR = $$DESTDIR/.ui
+#
+
+#
+# Файлы приложения, кроме его точки входа и ресурсов пакета
+#
+SOURCES -= scenarist-desktop/main.cpp
+SOURCES = $$replace(SOURCES, ^scenarist-, $$APP_DIR/scenarist-)
+HEADERS = $$replace(HEADERS, ^scenarist-, $$APP_DIR/scenarist-)
+FORMS = $$replace(FORMS, ^scenarist-, $$APP_DIR/scenarist-)
+RESOURCES = $$replace(RESOURCES, ^scenarist-, $$APP_DIR/scenarist-)
+
+OTHER_FILES =
+win32:RC_FILE =
+macx {
+    ICON =
+    QMAKE_INFO_PLIST =
+}
+win32-msvc*:QMAKE_LFLAGS_WINDOWS =
+#
+
+SOURCES += \
+    main.cpp
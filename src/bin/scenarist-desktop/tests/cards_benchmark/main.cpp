@@ -0,0 +1,83 @@
+#include <ManagementLayer/Scenario/ScenarioCardsManager.h>
+
+#include <Domain/Scenario.h>
+
+#include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioModel.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScriptTextCursor.h>
+
+#include <DataLayer/Database/Database.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QWidget>
+
+using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::ScenarioDocument;
+using BusinessLogic::ScenarioTemplateFacade;
+using BusinessLogic::ScriptTextCursor;
+using ManagementLayer::ScenarioCardsManager;
+
+namespace {
+    /**
+     * @brief Количество добавляемых сцен
+     */
+    const int SCENES_COUNT = 1000;
+}
+
+
+int main(int argc, char* argv[])
+{
+    QApplication application(argc, argv);
+    QTextStream out(stdout);
+
+    //
+    // Работаем с новым проектом во временном каталоге, чтобы не трогать проекты пользователя
+    //
+    QTemporaryDir projectDir;
+    if (!projectDir.isValid()) {
+        out << "FAIL unable to create a temporary directory" << endl;
+        return 1;
+    }
+    DatabaseLayer::Database::setCurrentFile(projectDir.path() + "/cards_benchmark.kitsp");
+
+    //
+    // Загружаем пустой сценарий и формируем по нему схему карточек
+    //
+    Domain::Scenario scenario(Domain::Identifier(), QString(), QString(), false);
+    ScenarioDocument script;
+    script.load(&scenario);
+    ScenarioCardsManager cardsManager(nullptr, nullptr);
+    cardsManager.load(script.model(), QString());
+    cardsManager.view()->resize(1280, 800);
+    cardsManager.view()->show();
+    QApplication::processEvents();
+
+    //
+    // Добавляем сцены в конец сценария за один проход цикла событий, как при вставке
+    // большого фрагмента, и замеряем отдельно обновление текста и модели
+    // и применение накопленных изменений к карточкам
+    //
+    const ScenarioBlockStyle sceneHeadingStyle =
+            ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::SceneHeading);
+    QElapsedTimer timer;
+    timer.start();
+    ScriptTextCursor cursor(script.document());
+    for (int sceneIndex = 0; sceneIndex < SCENES_COUNT; ++sceneIndex) {
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertBlock(sceneHeadingStyle.blockFormat(), sceneHeadingStyle.charFormat());
+        cursor.insertText(QString("INT. BENCHMARK %1 - DAY").arg(sceneIndex + 1));
+    }
+    const qint64 textTime = timer.restart();
+
+    QApplication::processEvents();
+    const qint64 cardsTime = timer.elapsed();
+
+    out << SCENES_COUNT << " scenes: text and model " << textTime << " ms, "
+        << "cards " << cardsTime << " ms" << endl;
+    return 0;
+}
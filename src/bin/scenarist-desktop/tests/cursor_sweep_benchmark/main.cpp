@@ -0,0 +1,231 @@
+#include <Domain/Scenario.h>
+
+#include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScriptTextCursor.h>
+
+#include <DataLayer/Database/Database.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QModelIndex>
+#include <QPersistentModelIndex>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+
+using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::ScenarioDocument;
+using BusinessLogic::ScenarioTemplateFacade;
+using BusinessLogic::ScriptTextCursor;
+
+namespace {
+    /**
+     * @brief Количество сцен в сценарии по умолчанию
+     */
+    const int DEFAULT_SCENES_COUNT = 3000;
+
+    /**
+     * @brief Бюджет одного кадра, мкс
+     */
+    const qint64 FRAME_BUDGET = 16000;
+
+    /**
+     * @brief Название и описание сцены, показываемые на панели сцены
+     */
+    struct ScenePanel {
+        QString title;
+        QString description;
+    };
+
+    /**
+     * @brief Статистика обработки перемещений курсора
+     */
+    struct SweepStats {
+        qint64 total = 0;
+        qint64 worst = 0;
+        int moves = 0;
+    };
+
+    /**
+     * @brief Добавить в конец документа блок заданного типа
+     * @return Позиция начала блока
+     */
+    static int appendBlock(ScriptTextCursor& _cursor, ScenarioBlockStyle::Type _type, const QString& _text) {
+        const ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(_type);
+        _cursor.movePosition(QTextCursor::End);
+        if (_cursor.document()->isEmpty()) {
+            _cursor.setBlockFormat(style.blockFormat());
+            _cursor.setBlockCharFormat(style.charFormat());
+        } else {
+            _cursor.insertBlock(style.blockFormat(), style.charFormat());
+        }
+        const int position = _cursor.block().position();
+        _cursor.insertText(_text);
+        return position;
+    }
+
+    /**
+     * @brief Сформировать сценарий из заданного количества сцен
+     *
+     * У половины сцен задано название, а у трети - описание, чтобы при обновлении панели
+     * сцены работали обе ветки: и с названием, и с заголовком вместо него
+     */
+    static void buildScript(ScenarioDocument& _script, int _scenesCount) {
+        QVector<int> headingsPositions;
+        ScriptTextCursor cursor(_script.document());
+        cursor.beginEditBlock();
+        for (int sceneIndex = 0; sceneIndex < _scenesCount; ++sceneIndex) {
+            headingsPositions.append(
+                appendBlock(cursor, ScenarioBlockStyle::SceneHeading, QString("INT. LOCATION %1 - DAY").arg(sceneIndex + 1)));
+            appendBlock(cursor, ScenarioBlockStyle::Action,
+                        "The room is quiet. Somebody walks to the window and looks outside for a long time.");
+            appendBlock(cursor, ScenarioBlockStyle::Character, "JOHN");
+            appendBlock(cursor, ScenarioBlockStyle::Dialogue, "We have to leave before the sun goes down.");
+        }
+        cursor.endEditBlock();
+
+        //
+        // Заполняем сцены с конца, чтобы изменения не сдвигали позиции ещё не заполненных сцен
+        //
+        for (int sceneIndex = _scenesCount - 1; sceneIndex >= 0; --sceneIndex) {
+            if (sceneIndex % 3 == 0) {
+                _script.setItemDescriptionAtPosition(headingsPositions.at(sceneIndex),
+                                                     QString("Description of scene %1").arg(sceneIndex + 1));
+            }
+            if (sceneIndex % 2 == 0) {
+                _script.setItemTitleAtPosition(headingsPositions.at(sceneIndex),
+                                               QString("Scene %1").arg(sceneIndex + 1));
+            }
+        }
+    }
+
+    /**
+     * @brief Определить название и описание сцены в позиции
+     */
+    static ScenePanel scenePanelAt(ScenarioDocument& _script, int _position) {
+        ScenePanel panel;
+        panel.title = _script.itemTitleAtPosition(_position);
+        if (panel.title.isEmpty()) {
+            panel.title = _script.itemHeaderAtPosition(_position);
+        }
+        panel.description = _script.itemDescriptionAtPosition(_position);
+        return panel;
+    }
+
+    /**
+     * @brief Учесть время обработки одного перемещения курсора
+     */
+    static void countMove(SweepStats& _stats, qint64 _elapsed) {
+        _stats.total += _elapsed;
+        _stats.worst = qMax(_stats.worst, _elapsed);
+        ++_stats.moves;
+    }
+
+    /**
+     * @brief Пройти курсором по всему сценарию, обновляя навигатор и панель сцены на каждом шаге
+     *
+     * @param _skipSameScene - false, чтобы обновлять панель на каждом шаге, как было раньше,
+     *        true, чтобы пропускать обновление, пока курсор остаётся в той же сцене
+     */
+    static SweepStats sweep(ScenarioDocument& _script, bool _skipSameScene, QVector<ScenePanel>* _panels = nullptr) {
+        SweepStats stats;
+        QPersistentModelIndex cursorSceneIndex;
+        ScenePanel panel;
+        QElapsedTimer timer;
+        const int documentEnd = _script.document()->characterCount() - 1;
+        for (int position = 0; position <= documentEnd; ++position) {
+            timer.start();
+
+            //
+            // Выделение элемента в навигаторе
+            //
+            const QModelIndex navigatorIndex = _script.itemIndexAtPosition(position);
+            Q_UNUSED(navigatorIndex);
+
+            //
+            // Название и описание сцены под курсором
+            //
+            if (_skipSameScene) {
+                const QModelIndex sceneIndex = _script.itemIndexAtPosition(position);
+                if (!cursorSceneIndex.isValid() || cursorSceneIndex != sceneIndex) {
+                    cursorSceneIndex = sceneIndex;
+                    panel = scenePanelAt(_script, position);
+                }
+            } else {
+                panel = scenePanelAt(_script, position);
+            }
+
+            countMove(stats, timer.nsecsElapsed() / 1000);
+            if (_panels != nullptr) {
+                _panels->append(panel);
+            }
+        }
+        return stats;
+    }
+
+    /**
+     * @brief Сформировать строку со статистикой прохода
+     */
+    static QString describe(const SweepStats& _stats) {
+        return QString("%1 ms total, %2 us per move, worst %3 us")
+                .arg(_stats.total / 1000)
+                .arg(double(_stats.total) / qMax(_stats.moves, 1), 0, 'f', 2)
+                .arg(_stats.worst);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    QApplication application(argc, argv);
+    QTextStream out(stdout);
+
+    int scenesCount = DEFAULT_SCENES_COUNT;
+    if (application.arguments().size() > 1) {
+        scenesCount = qMax(1, application.arguments().at(1).toInt());
+    }
+
+    //
+    // Стили блоков берутся из шаблона, а настройки читаются из проекта,
+    // поэтому работаем с новым проектом во временном каталоге
+    //
+    QTemporaryDir projectDir;
+    if (!projectDir.isValid()) {
+        out << "FAIL unable to create a temporary directory" << endl;
+        return 1;
+    }
+    DatabaseLayer::Database::setCurrentFile(projectDir.path() + "/cursor_sweep_benchmark.kitsp");
+
+    Domain::Scenario scenario(Domain::Identifier(), QString(), QString(), false);
+    ScenarioDocument script;
+    script.load(&scenario);
+    buildScript(script, scenesCount);
+
+    //
+    // Пропуск обновлений не должен менять то, что показывается на панели сцены
+    //
+    QVector<ScenePanel> expectedPanels;
+    sweep(script, false, &expectedPanels);
+    QVector<ScenePanel> actualPanels;
+    sweep(script, true, &actualPanels);
+    for (int position = 0; position < expectedPanels.size(); ++position) {
+        if (expectedPanels.at(position).title != actualPanels.at(position).title
+            || expectedPanels.at(position).description != actualPanels.at(position).description) {
+            out << "FAIL position " << position << ": scene panel differs" << endl;
+            return 1;
+        }
+    }
+
+    const SweepStats everyMove = sweep(script, false);
+    const SweepStats sceneChanges = sweep(script, true);
+    out << "OK   " << scenesCount << " scenes, " << everyMove.moves << " cursor moves" << endl
+        << "     refresh on every move: " << describe(everyMove) << endl
+        << "     refresh on scene change: " << describe(sceneChanges) << endl;
+    if (sceneChanges.worst > FRAME_BUDGET) {
+        out << "FAIL worst move exceeds the " << FRAME_BUDGET / 1000 << " ms frame budget" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "legacy_rename.h"
+
+#include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextBlockParsers.h>
+
+#include <3rd_party/Helpers/TextEditHelper.h>
+
+#include <QStringList>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+
+using BusinessLogic::ScenarioBlockStyle;
+
+
+void LegacyRename::renameCharacter(QTextDocument* _document, const QString& _oldName, const QString& _newName)
+{
+    QTextCursor cursor(_document);
+    while (!cursor.isNull() && !cursor.atEnd()) {
+        cursor = _document->find(_oldName, cursor);
+
+        if (!cursor.isNull()) {
+            //
+            // Выделенным должно быть именно имя, а не составная часть другого имени
+            //
+            bool replaceSelection = false;
+
+            //
+            // Если мы в блоке персонажа
+            //
+            if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::Character) {
+                const QString name = BusinessLogic::CharacterParser::name(cursor.block().text());
+                if (name == TextEditHelper::smartToUpper(cursor.selectedText())) {
+                    replaceSelection = true;
+                }
+            }
+            //
+            // Если в блоке участники сцены
+            //
+            else if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::SceneCharacters) {
+                const QStringList names = BusinessLogic::SceneCharactersParser::characters(cursor.block().text());
+                if (names.contains(TextEditHelper::smartToUpper(cursor.selectedText()))) {
+                    //
+                    // Убедимся, что выделено именно имя, а не часть другого имени
+                    //
+                    QTextCursor checkCursor(cursor);
+                    // ... всё ли в порядке слева
+                    bool atLeftAllOk = false;
+                    checkCursor.setPosition(cursor.selectionStart());
+                    if (checkCursor.atBlockStart()) {
+                        atLeftAllOk = true;
+                    } else {
+                        checkCursor.movePosition(QTextCursor::PreviousCharacter, QTextCursor::KeepAnchor);
+                        if (checkCursor.selectedText() == " "
+                            || checkCursor.selectedText() == ",") {
+                            atLeftAllOk = true;
+                        } else {
+                            atLeftAllOk = false;
+                        }
+                    }
+                    // ... всё ли в порядке справа
+                    bool atRightAllOk = false;
+                    checkCursor.setPosition(cursor.selectionEnd());
+                    if (checkCursor.atBlockEnd()) {
+                        atRightAllOk = true;
+                    } else {
+                        checkCursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+                        if (checkCursor.selectedText() == " "
+                            || checkCursor.selectedText() == ",") {
+                            atRightAllOk = true;
+                        } else {
+                            atRightAllOk = false;
+                        }
+                    }
+                    // ... если со всех сторон всё в порядке - заменяем
+                    if (atLeftAllOk && atRightAllOk) {
+                        replaceSelection = true;
+                    }
+                }
+            }
+
+            //
+            // Если выделено имя для замены, меняем его
+            //
+            if (replaceSelection) {
+                cursor.insertText(_newName);
+            }
+        }
+    }
+}
+
+void LegacyRename::renameLocation(QTextDocument* _document, const QString& _oldName, const QString& _newName)
+{
+    QTextCursor cursor(_document);
+    while (!cursor.isNull() && !cursor.atEnd()) {
+        cursor = _document->find(_oldName, cursor);
+
+        if (!cursor.isNull()) {
+            //
+            // Выделенным должно быть именно локация, а не составная часть другой локации
+            //
+            bool replaceSelection = false;
+
+            //
+            // Если мы в блоке времени и места
+            //
+            if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::SceneHeading) {
+                const QString location = BusinessLogic::SceneHeadingParser::locationName(cursor.block().text());
+                if (location == TextEditHelper::smartToUpper(cursor.selectedText())) {
+                    replaceSelection = true;
+                }
+            }
+
+            //
+            // Если выделено имя для замены, меняем его
+            //
+            if (replaceSelection) {
+                cursor.insertText(_newName);
+            }
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef LEGACY_RENAME_H
+#define LEGACY_RENAME_H
+
+class QString;
+class QTextDocument;
+
+
+/**
+ * @brief Переименование персонажей и локаций в том виде, в котором оно было до индекса имён
+ *
+ * Используется как образец: результат переименования через индекс должен с ним совпадать
+ */
+namespace LegacyRename
+{
+    /**
+     * @brief Обновить текст сценария для нового имени персонажа
+     */
+    void renameCharacter(QTextDocument* _document, const QString& _oldName, const QString& _newName);
+
+    /**
+     * @brief Обновить текст сценария для нового названия локации
+     */
+    void renameLocation(QTextDocument* _document, const QString& _oldName, const QString& _newName);
+}
+
+#endif // LEGACY_RENAME_H
@@ -0,0 +1,146 @@
+#include "legacy_rename.h"
+
+#include <ManagementLayer/Scenario/ScriptNamesIndex.h>
+
+#include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+
+#include <DataLayer/Database/Database.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextStream>
+#include <QVector>
+
+using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::ScenarioTemplateFacade;
+using ManagementLayer::ScriptNamesIndex;
+
+namespace {
+    /**
+     * @brief Размеры сценариев, на которых замеряется переименование, в сценах
+     */
+    const QVector<int> SCENES_COUNTS = { 200, 1000, 2000 };
+
+    /**
+     * @brief Переименовываемые персонаж и локация
+     */
+    /** @{ */
+    const QString OLD_CHARACTER = "JOHN";
+    const QString NEW_CHARACTER = "ROBERT";
+    const QString OLD_LOCATION = "HOUSE";
+    const QString NEW_LOCATION = "CASTLE";
+    /** @} */
+
+    /**
+     * @brief Добавить в конец документа блок заданного типа
+     */
+    static void appendBlock(QTextCursor& _cursor, ScenarioBlockStyle::Type _type, const QString& _text) {
+        const ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(_type);
+        if (_cursor.document()->isEmpty()) {
+            _cursor.setBlockFormat(style.blockFormat());
+            _cursor.setBlockCharFormat(style.charFormat());
+        } else {
+            _cursor.insertBlock(style.blockFormat(), style.charFormat());
+        }
+        _cursor.insertText(_text);
+    }
+
+    /**
+     * @brief Сформировать сценарий из заданного количества сцен
+     *
+     * Кроме переименовываемых имён в тексте есть имена, которые их содержат, и упоминания
+     * в блоках, где имена не заменяются, чтобы проверить и границы слов, и типы блоков
+     */
+    static void buildScript(QTextDocument* _document, int _scenesCount) {
+        QTextCursor cursor(_document);
+        cursor.beginEditBlock();
+        for (int sceneIndex = 0; sceneIndex < _scenesCount; ++sceneIndex) {
+            QString location = QString("STREET %1").arg(sceneIndex);
+            if (sceneIndex % 10 == 0) {
+                location = OLD_LOCATION;
+            } else if (sceneIndex % 7 == 0) {
+                location = OLD_LOCATION + "BOAT";
+            }
+            appendBlock(cursor, ScenarioBlockStyle::SceneHeading, QString("INT. %1 - DAY").arg(location));
+            appendBlock(cursor, ScenarioBlockStyle::SceneCharacters, "JOHN, MARY, JOHNNY");
+            appendBlock(cursor, ScenarioBlockStyle::Action, "JOHN looks at MARY and JOHNNY in the HOUSE.");
+            appendBlock(cursor, ScenarioBlockStyle::Character, sceneIndex % 2 == 0 ? "JOHN" : "JOHNNY (V.O.)");
+            appendBlock(cursor, ScenarioBlockStyle::Dialogue, "Hello.");
+            appendBlock(cursor, ScenarioBlockStyle::Character, "MARY");
+            appendBlock(cursor, ScenarioBlockStyle::Dialogue, "Hi, JOHN.");
+        }
+        cursor.endEditBlock();
+    }
+
+    /**
+     * @brief Переименовать персонажа и локацию обоими способами, сверить результаты и замерить время
+     */
+    static bool measure(int _scenesCount, QTextStream& _out) {
+        QTextDocument legacyDocument;
+        buildScript(&legacyDocument, _scenesCount);
+        QTextDocument indexedDocument;
+        buildScript(&indexedDocument, _scenesCount);
+
+        QElapsedTimer timer;
+        timer.start();
+        LegacyRename::renameCharacter(&legacyDocument, OLD_CHARACTER, NEW_CHARACTER);
+        LegacyRename::renameLocation(&legacyDocument, OLD_LOCATION, NEW_LOCATION);
+        const qint64 legacyTime = timer.restart();
+
+        //
+        // Индекс строится при первом обращении, а дальше поддерживается при редактировании,
+        // поэтому время его построения учитываем отдельно
+        //
+        ScriptNamesIndex* namesIndex = new ScriptNamesIndex(&indexedDocument);
+        namesIndex->characters();
+        const qint64 indexTime = timer.restart();
+        namesIndex->renameCharacter(OLD_CHARACTER, NEW_CHARACTER);
+        namesIndex->renameLocation(OLD_LOCATION, NEW_LOCATION);
+        const qint64 renameTime = timer.elapsed();
+
+        if (legacyDocument.toPlainText() != indexedDocument.toPlainText()) {
+            _out << "FAIL " << _scenesCount << " scenes: renamed texts differ" << endl;
+            return false;
+        }
+        if (namesIndex->characters().contains(OLD_CHARACTER)
+            || !namesIndex->characters().contains(NEW_CHARACTER)
+            || namesIndex->locations().contains(OLD_LOCATION)
+            || !namesIndex->locations().contains(NEW_LOCATION)) {
+            _out << "FAIL " << _scenesCount << " scenes: index is out of date after rename" << endl;
+            return false;
+        }
+
+        _out << "OK   " << _scenesCount << " scenes, " << indexedDocument.blockCount() << " blocks: "
+             << "legacy " << legacyTime << " ms, "
+             << "index build " << indexTime << " ms, "
+             << "indexed rename " << renameTime << " ms" << endl;
+        return true;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    QApplication application(argc, argv);
+    QTextStream out(stdout);
+
+    //
+    // Стили блоков берутся из шаблона, а настройки читаются из проекта,
+    // поэтому работаем с новым проектом во временном каталоге
+    //
+    QTemporaryDir projectDir;
+    if (!projectDir.isValid()) {
+        out << "FAIL unable to create a temporary directory" << endl;
+        return 1;
+    }
+    DatabaseLayer::Database::setCurrentFile(projectDir.path() + "/names_index_benchmark.kitsp");
+
+    bool success = true;
+    for (int scenesCount : SCENES_COUNTS) {
+        success = measure(scenesCount, out) && success;
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+#include <ManagementLayer/Scenario/ScenarioManager.h>
+
+#include <Domain/Scenario.h>
+
+#include <BusinessLayer/ScenarioDocument/ScenarioDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTemplate.h>
+#include <BusinessLayer/ScenarioDocument/ScenarioTextDocument.h>
+#include <BusinessLayer/ScenarioDocument/ScriptTextCursor.h>
+
+#include <DataLayer/Database/Database.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QWidget>
+
+using BusinessLogic::ScenarioBlockStyle;
+using BusinessLogic::ScenarioDocument;
+using BusinessLogic::ScenarioTemplateFacade;
+using BusinessLogic::ScriptTextCursor;
+using ManagementLayer::ScenarioManager;
+
+namespace {
+    /**
+     * @brief Количество сцен в сценарии по умолчанию
+     */
+    const int DEFAULT_SCENES_COUNT = 2000;
+
+    /**
+     * @brief Во сколько раз черновик меньше сценария
+     */
+    const int DRAFT_SCALE = 10;
+
+    /**
+     * @brief Добавить в конец документа сцены
+     */
+    static void appendScenes(ScenarioDocument* _script, int _scenesCount) {
+        const ScenarioBlockStyle::Type types[] = {
+            ScenarioBlockStyle::SceneHeading,
+            ScenarioBlockStyle::Action,
+            ScenarioBlockStyle::Character,
+            ScenarioBlockStyle::Dialogue
+        };
+        const QString texts[] = {
+            "INT. LOCATION %1 - DAY",
+            "The room is quiet. Somebody walks to the window and looks outside for a long time.",
+            "JOHN",
+            "We have to leave before the sun goes down."
+        };
+
+        ScriptTextCursor cursor(_script->document());
+        cursor.beginEditBlock();
+        for (int sceneIndex = 0; sceneIndex < _scenesCount; ++sceneIndex) {
+            for (int blockIndex = 0; blockIndex < 4; ++blockIndex) {
+                const ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(types[blockIndex]);
+                cursor.movePosition(QTextCursor::End);
+                cursor.insertBlock(style.blockFormat(), style.charFormat());
+                cursor.insertText(blockIndex == 0 ? texts[blockIndex].arg(sceneIndex + 1) : texts[blockIndex]);
+            }
+        }
+        cursor.endEditBlock();
+    }
+
+    /**
+     * @brief Сохранить проект так же, как это делает приложение, и замерить время сохранения
+     * @return Время сохранения в мс, или -1, если сохранение не удалось
+     */
+    static qint64 save(ScenarioManager& _manager) {
+        QElapsedTimer timer;
+        timer.start();
+        DatabaseLayer::Database::transaction();
+        _manager.saveCurrentProject();
+        DatabaseLayer::Database::commit();
+        const qint64 elapsed = timer.elapsed();
+        return DatabaseLayer::Database::hasError() ? -1 : elapsed;
+    }
+
+    /**
+     * @brief Проверить, что сохранённый текст сценария и черновика совпадает с редактируемым
+     *
+     * Пропущенная при сохранении часть проекта должна оставаться такой же, как в редакторе
+     */
+    static bool isSaved(ScenarioManager& _manager) {
+        return _manager.scenario()->scenario()->text() == _manager.scenario()->save()
+                && _manager.scenarioDraft()->scenario()->text() == _manager.scenarioDraft()->save();
+    }
+
+    /**
+     * @brief Сохранить проект, проверить результат и вывести время сохранения
+     */
+    static bool measure(ScenarioManager& _manager, const QString& _name, QTextStream& _out) {
+        QApplication::processEvents();
+        const qint64 saveTime = save(_manager);
+        if (saveTime < 0) {
+            _out << "FAIL " << _name << ": database error" << endl;
+            return false;
+        }
+        if (!isSaved(_manager)) {
+            _out << "FAIL " << _name << ": saved text differs from the edited one" << endl;
+            return false;
+        }
+        _out << "OK   " << _name << ": " << saveTime << " ms" << endl;
+        return true;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    QApplication application(argc, argv);
+    QTextStream out(stdout);
+
+    int scenesCount = DEFAULT_SCENES_COUNT;
+    if (application.arguments().size() > 1) {
+        scenesCount = qMax(DRAFT_SCALE, application.arguments().at(1).toInt());
+    }
+
+    //
+    // Работаем с новым проектом во временном каталоге, чтобы не трогать проекты пользователя
+    //
+    QTemporaryDir projectDir;
+    if (!projectDir.isValid()) {
+        out << "FAIL unable to create a temporary directory" << endl;
+        return 1;
+    }
+    DatabaseLayer::Database::setCurrentFile(projectDir.path() + "/project_save_benchmark.kitsp");
+
+    QWidget window;
+    ScenarioManager manager(nullptr, &window);
+    manager.loadCurrentProject();
+    appendScenes(manager.scenario(), scenesCount);
+    appendScenes(manager.scenarioDraft(), scenesCount / DRAFT_SCALE);
+
+    out << scenesCount << " scenes in the script, " << scenesCount / DRAFT_SCALE << " in the draft" << endl;
+
+    bool success = measure(manager, "first save", out);
+
+    //
+    // Повторное сохранение без изменений ничего не должно записывать
+    //
+    success = measure(manager, "save without changes", out) && success;
+
+    //
+    // При изменении черновика сценарий и схема карточек не пересохраняются
+    //
+    appendScenes(manager.scenarioDraft(), 1);
+    success = measure(manager, "save after a draft edit", out) && success;
+
+    //
+    // Изменение сценария пересохраняет и его схему карточек, но не черновик
+    //
+    appendScenes(manager.scenario(), 1);
+    success = measure(manager, "save after a script edit", out) && success;
+
+    //
+    // Так сохранялся проект при любом изменении
+    //
+    manager.markCurrentProjectChanged();
+    success = measure(manager, "full rewrite", out) && success;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+#include <ManagementLayer/Research/ResearchImagesCache.h>
+
+#include <DataLayer/Database/Database.h>
+#include <DataLayer/DataStorageLayer/ResearchStorage.h>
+#include <DataLayer/DataStorageLayer/StorageFacade.h>
+
+#include <Domain/Research.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPixmap>
+#include <QScreen>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+using DataStorageLayer::StorageFacade;
+using Domain::Research;
+using ManagementLayer::ResearchImagesCache;
+
+namespace {
+    /**
+     * @brief Количество изображений в галерее по умолчанию
+     */
+    const int DEFAULT_IMAGES_COUNT = 24;
+
+    /**
+     * @brief Размер изображений галереи, как у снимков с фотокамеры
+     */
+    const QSize IMAGE_SIZE(4000, 3000);
+
+    /**
+     * @brief Сколько ждать подготовки галереи, прежде чем считать замер неудавшимся, мс
+     */
+    const int LOADING_TIMEOUT = 120000;
+
+    /**
+     * @brief Бюджет одного кадра, мс
+     */
+    const qint64 FRAME_BUDGET = 16;
+
+    /**
+     * @brief Результаты одного открытия галереи
+     */
+    struct GalleryOpening {
+        qint64 requestTime = 0;
+        qint64 firstImageTime = -1;
+        qint64 allImagesTime = -1;
+        qint64 deliveredBytes = 0;
+        int deliveredCount = 0;
+        bool inOrder = true;
+        bool fitsScreen = true;
+    };
+
+    /**
+     * @brief Объём памяти, занимаемый изображением, в байтах
+     */
+    static qint64 imageBytes(const QPixmap& _image) {
+        return qint64(_image.width()) * _image.height() * _image.depth() / 8;
+    }
+
+    /**
+     * @brief Сформировать изображение, которое плохо сжимается и отличается от остальных
+     */
+    static QPixmap makeImage(int _index) {
+        QPixmap image(IMAGE_SIZE);
+        QPainter painter(&image);
+        QLinearGradient gradient(0, 0, IMAGE_SIZE.width(), IMAGE_SIZE.height());
+        gradient.setColorAt(0, QColor::fromHsv((_index * 37) % 360, 200, 230));
+        gradient.setColorAt(1, QColor::fromHsv((_index * 37 + 180) % 360, 200, 80));
+        painter.fillRect(image.rect(), gradient);
+        painter.drawText(image.rect(), Qt::AlignCenter, QString::number(_index + 1));
+        return image;
+    }
+
+    /**
+     * @brief Открыть галерею и дождаться, пока кэш отдаст все её изображения
+     */
+    static GalleryOpening openGallery(ResearchImagesCache& _cache, Research* _gallery,
+        const QList<Research*>& _images, const QSize& _screenSize) {
+        GalleryOpening opening;
+        QElapsedTimer timer;
+        QEventLoop loop;
+        const QMetaObject::Connection connection =
+                QObject::connect(&_cache, &ResearchImagesCache::imageReady,
+                                 [&] (Research* _owner, int _index, const QPixmap& _image) {
+            if (_owner != _gallery) {
+                return;
+            }
+            if (opening.firstImageTime < 0) {
+                opening.firstImageTime = timer.elapsed();
+            }
+            opening.inOrder = opening.inOrder && _index == opening.deliveredCount;
+            opening.fitsScreen = opening.fitsScreen
+                                 && _image.width() <= _screenSize.width()
+                                 && _image.height() <= _screenSize.height();
+            opening.deliveredBytes += imageBytes(_image);
+            ++opening.deliveredCount;
+            if (opening.deliveredCount == _images.size()) {
+                opening.allImagesTime = timer.elapsed();
+                loop.quit();
+            }
+        });
+
+        //
+        // Запрос выполняется в потоке интерфейса, поэтому его время - это то, на сколько
+        // открытие галереи задерживает отрисовку
+        //
+        timer.start();
+        _cache.requestGalleryImages(_gallery, _images);
+        opening.requestTime = timer.elapsed();
+        if (opening.deliveredCount < _images.size()) {
+            QTimer::singleShot(LOADING_TIMEOUT, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+
+        QObject::disconnect(connection);
+        return opening;
+    }
+
+    /**
+     * @brief Вывести результаты открытия галереи и проверить их
+     */
+    static bool report(const QString& _name, const GalleryOpening& _opening, int _imagesCount,
+        QTextStream& _out) {
+        if (_opening.deliveredCount != _imagesCount) {
+            _out << "FAIL " << _name << ": " << _opening.deliveredCount << " of " << _imagesCount
+                 << " images delivered" << endl;
+            return false;
+        }
+        if (!_opening.inOrder) {
+            _out << "FAIL " << _name << ": images delivered out of order" << endl;
+            return false;
+        }
+        if (!_opening.fitsScreen) {
+            _out << "FAIL " << _name << ": images larger than the screen delivered" << endl;
+            return false;
+        }
+
+        _out << "OK   " << _name << ": request " << _opening.requestTime << " ms, "
+             << "first image " << _opening.firstImageTime << " ms, "
+             << "all images " << _opening.allImagesTime << " ms, "
+             << _opening.deliveredBytes / (1024 * 1024) << " MB of images" << endl;
+        if (_opening.requestTime > FRAME_BUDGET) {
+            _out << "FAIL " << _name << ": request exceeds the " << FRAME_BUDGET << " ms frame budget" << endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    QApplication application(argc, argv);
+    QTextStream out(stdout);
+
+    int imagesCount = DEFAULT_IMAGES_COUNT;
+    if (application.arguments().size() > 1) {
+        imagesCount = qMax(1, application.arguments().at(1).toInt());
+    }
+
+    //
+    // Элементы разработки создаются хранилищем, поэтому работаем с новым проектом
+    // во временном каталоге
+    //
+    QTemporaryDir projectDir;
+    if (!projectDir.isValid()) {
+        out << "FAIL unable to create a temporary directory" << endl;
+        return 1;
+    }
+    DatabaseLayer::Database::setCurrentFile(projectDir.path() + "/research_gallery_benchmark.kitsp");
+
+    Research* gallery =
+            StorageFacade::researchStorage()->storeResearch(nullptr, Research::ImagesGallery, 0, "Gallery");
+    QList<Research*> images;
+    qint64 sourceBytes = 0;
+    for (int imageIndex = 0; imageIndex < imagesCount; ++imageIndex) {
+        Research* image =
+                StorageFacade::researchStorage()->storeResearch(
+                    gallery, Research::Image, imageIndex, QString("Image %1").arg(imageIndex + 1));
+        image->setImage(makeImage(imageIndex));
+        sourceBytes += imageBytes(image->image());
+        images.append(image);
+    }
+
+    QSize screenSize(1920, 1080);
+    if (QScreen* screen = QGuiApplication::primaryScreen()) {
+        screenSize = screen->size() * screen->devicePixelRatio();
+    }
+
+    out << imagesCount << " images of " << IMAGE_SIZE.width() << "x" << IMAGE_SIZE.height() << ", "
+        << sourceBytes / (1024 * 1024) << " MB at full resolution, screen "
+        << screenSize.width() << "x" << screenSize.height() << endl;
+
+    //
+    // Первое открытие готовит изображения в фоне, а повторное берёт из кэша те,
+    // что в нём уместились, и готовит заново вытесненные
+    //
+    ResearchImagesCache cache;
+    bool success = report("first opening", openGallery(cache, gallery, images, screenSize), imagesCount, out);
+    success = report("second opening", openGallery(cache, gallery, images, screenSize), imagesCount, out)
+              && success;
+    return success ? 0 : 1;
+}
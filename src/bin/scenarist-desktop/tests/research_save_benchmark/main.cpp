@@ -0,0 +1,184 @@
+#include <ManagementLayer/Research/ResearchManager.h>
+
+#include <Domain/Research.h>
+
+#include <BusinessLayer/Research/ResearchModel.h>
+#include <BusinessLayer/Research/ResearchModelItem.h>
+
+#include <DataLayer/Database/Database.h>
+#include <DataLayer/DataStorageLayer/ResearchStorage.h>
+#include <DataLayer/DataStorageLayer/StorageFacade.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QWidget>
+
+using BusinessLogic::ResearchModel;
+using BusinessLogic::ResearchModelItem;
+using DataStorageLayer::StorageFacade;
+using Domain::Research;
+using ManagementLayer::ResearchManager;
+
+namespace {
+    /**
+     * @brief Количество папок разработки
+     */
+    const int FOLDERS_COUNT = 20;
+
+    /**
+     * @brief Количество текстовых документов разработки по умолчанию
+     */
+    const int DEFAULT_DOCUMENTS_COUNT = 1000;
+
+    /**
+     * @brief Сформировать текст документа разработки размером в несколько килобайт
+     */
+    static QString documentText(int _index, int _revision) {
+        QString text = QString("<p>Document %1, revision %2.</p>").arg(_index + 1).arg(_revision);
+        for (int paragraph = 0; paragraph < 20; ++paragraph) {
+            text += "<p>Notes about the characters, the places and the history of the story world, "
+                    "collected while working on the script.</p>";
+        }
+        return text;
+    }
+
+    /**
+     * @brief Сохранить разработку так же, как это делает приложение, и замерить время сохранения
+     * @return Время сохранения в мс, или -1, если сохранение не удалось
+     */
+    static qint64 save(ResearchManager& _manager) {
+        QElapsedTimer timer;
+        timer.start();
+        DatabaseLayer::Database::transaction();
+        _manager.saveResearch();
+        DatabaseLayer::Database::commit();
+        const qint64 elapsed = timer.elapsed();
+        return DatabaseLayer::Database::hasError() ? -1 : elapsed;
+    }
+
+    /**
+     * @brief Сохранить разработку и вывести время сохранения
+     */
+    static bool measure(ResearchManager& _manager, const QString& _name, QTextStream& _out) {
+        QApplication::processEvents();
+        const qint64 saveTime = save(_manager);
+        if (saveTime < 0) {
+            _out << "FAIL " << _name << ": database error" << endl;
+            return false;
+        }
+        _out << "OK   " << _name << ": " << saveTime << " ms" << endl;
+        return true;
+    }
+
+    /**
+     * @brief Изменить текст документа так же, как это делает редактор, и сообщить об этом модели
+     * @note В модели кроме разработки есть и разделы проекта, поэтому документ ищется по названию
+     */
+    static bool editDocument(ResearchModel* _model, const QString& _name, const QString& _text) {
+        const QModelIndexList found =
+                _model->match(_model->index(0, 0), Qt::DisplayRole, _name, 1,
+                              Qt::MatchExactly | Qt::MatchRecursive);
+        ResearchModelItem* item = found.isEmpty() ? nullptr : _model->itemForIndex(found.first());
+        if (item == nullptr) {
+            return false;
+        }
+
+        item->research()->setDescription(_text);
+        _model->updateItem(item);
+        return true;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    QApplication application(argc, argv);
+    QTextStream out(stdout);
+
+    int documentsCount = DEFAULT_DOCUMENTS_COUNT;
+    if (application.arguments().size() > 1) {
+        documentsCount = qMax(FOLDERS_COUNT, application.arguments().at(1).toInt());
+    }
+    const int documentsInFolder = documentsCount / FOLDERS_COUNT;
+
+    //
+    // Элементы разработки создаются хранилищем, поэтому работаем с новым проектом
+    // во временном каталоге
+    //
+    QTemporaryDir projectDir;
+    if (!projectDir.isValid()) {
+        out << "FAIL unable to create a temporary directory" << endl;
+        return 1;
+    }
+    DatabaseLayer::Database::setCurrentFile(projectDir.path() + "/research_save_benchmark.kitsp");
+
+    DatabaseLayer::Database::transaction();
+    for (int folderIndex = 0; folderIndex < FOLDERS_COUNT; ++folderIndex) {
+        Research* folder =
+                StorageFacade::researchStorage()->storeResearch(
+                    nullptr, Research::Folder, folderIndex, QString("Folder %1").arg(folderIndex + 1));
+        for (int row = 0; row < documentsInFolder; ++row) {
+            const int documentIndex = folderIndex * documentsInFolder + row;
+            Research* document =
+                    StorageFacade::researchStorage()->storeResearch(
+                        folder, Research::Text, row, QString("Document %1").arg(documentIndex + 1));
+            document->setDescription(documentText(documentIndex, 0));
+            StorageFacade::researchStorage()->updateResearch(document);
+        }
+    }
+    DatabaseLayer::Database::commit();
+
+    out << FOLDERS_COUNT << " folders, " << FOLDERS_COUNT * documentsInFolder << " documents" << endl;
+
+    QWidget window;
+    ResearchManager manager(nullptr, &window);
+    manager.loadCurrentProject();
+    ResearchModel* model = static_cast<ResearchModel*>(manager.model());
+
+    //
+    // Сразу после загрузки сохранять нечего
+    //
+    bool success = measure(manager, "save without changes", out);
+
+    //
+    // Так сохранялась разработка при любом изменении
+    //
+    manager.markResearchChanged();
+    success = measure(manager, "full rewrite", out) && success;
+
+    //
+    // После изменения одного документа записывается только он
+    //
+    const int editedIndex = FOLDERS_COUNT * documentsInFolder / 2;
+    const QString editedName = QString("Document %1").arg(editedIndex + 1);
+    const QString editedText = documentText(editedIndex, 1);
+    if (!editDocument(model, editedName, editedText)) {
+        out << "FAIL " << editedName << " is not found in the research model" << endl;
+        return 1;
+    }
+    success = measure(manager, "save after one document edit", out) && success;
+
+    //
+    // Перечитываем разработку из базы и убеждаемся, что изменённый документ сохранился
+    // без полной перезаписи
+    //
+    manager.closeCurrentProject();
+    StorageFacade::clearStorages();
+    bool editedFound = false;
+    foreach (Domain::DomainObject* researchObject, StorageFacade::researchStorage()->all()->toList()) {
+        Research* research = dynamic_cast<Research*>(researchObject);
+        if (research != nullptr
+            && research->name() == editedName) {
+            editedFound = research->description() == editedText;
+            break;
+        }
+    }
+    if (!editedFound) {
+        out << "FAIL edited document was not saved" << endl;
+        success = false;
+    }
+
+    return success ? 0 : 1;
+}
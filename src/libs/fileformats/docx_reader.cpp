@@ -23,6 +23,7 @@
 
 #include "qtzip/QtZipReader"
 
+#include <QScopedPointer>
 #include <QTextDocument>
 #include <QXmlStreamAttributes>
 
@@ -129,17 +130,21 @@ void DocxReader::readData(QIODevice* device)
             QString::fromLatin1("word/document.xml")
         };
         for (int i = 0; i < 3; ++i) {
-            QByteArray data = zip.fileData(files[i]);
-            if (data.isEmpty()) {
+            // Parse while inflating instead of unpacking the whole file first
+            QScopedPointer<QIODevice> data(zip.fileDevice(files[i]));
+            if (data.isNull() || data->atEnd()) {
                 continue;
             }
-            m_xml.addData(data);
+            m_xml.setDevice(data.data());
             readContent();
-            if (m_xml.hasError()) {
+            const bool hasError = m_xml.hasError();
+            if (hasError) {
                 m_error = m_xml.errorString();
-                break;
             }
             m_xml.clear();
+            if (hasError) {
+                break;
+            }
         }
     } else {
         m_error = tr("Unable to open archive.");
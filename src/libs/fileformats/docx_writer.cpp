@@ -21,7 +21,7 @@
 
 #include "qtzip/QtZipWriter"
 
-#include <QBuffer>
+#include <QScopedPointer>
 #include <QTextBlock>
 #include <QTextBlockFormat>
 #include <QTextCharFormat>
@@ -62,8 +62,13 @@ bool DocxWriter::write(QIODevice* device, const QTextDocument* document)
 		"<Relationship Target=\"styles.xml\" Id=\"docRId0\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\"/>"
 		"</Relationships>");
 
-	zip.addFile(QString::fromLatin1("word/document.xml"),
-		writeDocument(document));
+	// Write the document straight into the archive, it is compressed on the fly
+	QScopedPointer<QIODevice> document_data(zip.fileDevice(QString::fromLatin1("word/document.xml")));
+	if (document_data.isNull()) {
+		return false;
+	}
+	writeDocument(document_data.data(), document);
+	document_data->close();
 
 	zip.addFile(QString::fromLatin1("word/styles.xml"),
 		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
@@ -164,12 +169,9 @@ bool DocxWriter::write(QIODevice* device, const QTextDocument* document)
 
 //-----------------------------------------------------------------------------
 
-QByteArray DocxWriter::writeDocument(const QTextDocument* document)
+void DocxWriter::writeDocument(QIODevice* device, const QTextDocument* document)
 {
-	QByteArray data;
-	QBuffer buffer(&data);
-	buffer.open(QIODevice::WriteOnly);
-	m_xml.setDevice(&buffer);
+	m_xml.setDevice(device);
 	m_xml.setCodec("UTF-8");
 	m_xml.writeNamespace(QString::fromLatin1("http://schemas.openxmlformats.org/wordprocessingml/2006/main"), QString::fromLatin1("w"));
 	m_xml.writeStartDocument(QString::fromLatin1("1.0"), true);
@@ -185,9 +187,7 @@ QByteArray DocxWriter::writeDocument(const QTextDocument* document)
 	m_xml.writeEndElement();
 
 	m_xml.writeEndDocument();
-	buffer.close();
-
-	return data;
+	m_xml.setDevice(0);
 }
 
 //-----------------------------------------------------------------------------
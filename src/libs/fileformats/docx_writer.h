@@ -45,7 +45,7 @@ public:
 	bool write(QIODevice* device, const QTextDocument* document);
 
 private:
-	QByteArray writeDocument(const QTextDocument* document);
+	void writeDocument(QIODevice* device, const QTextDocument* document);
 	void writeParagraph(const QTextBlock& block);
 	void writeText(const QString& text, int start, int end);
 	void writeParagraphProperties(const QTextBlockFormat& block_format, const QTextCharFormat& char_format);
@@ -8,6 +8,8 @@ DEFINES += FILEFORMATS_LIBRARY
 #
 CONFIG += qt thread warn_on staticlib
 
+QT += concurrent
+
 QMAKE_MAC_SDK = macosx10.13
 
 #
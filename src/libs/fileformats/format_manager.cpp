@@ -49,11 +49,12 @@ FormatReader* FormatManager::createReader(QIODevice* device, const QString& type
 
 	// Fall back to finding format from contents
 	if (!reader) {
-		if (OdtReader::canRead(device)) {
+		const QString detected_type = detectType(device);
+		if (detected_type == "odt") {
 			reader = new OdtReader;
-		} else if (DocxReader::canRead(device)) {
+		} else if (detected_type == "docx") {
 			reader = new DocxReader;
-		} else if (RtfReader::canRead(device)) {
+		} else if (detected_type == "rtf") {
 			reader = new RtfReader;
 		} else {
 			reader = new TxtReader;
@@ -65,6 +66,23 @@ FormatReader* FormatManager::createReader(QIODevice* device, const QString& type
 
 //-----------------------------------------------------------------------------
 
+QString FormatManager::detectType(QIODevice* device)
+{
+	// Peek the header once instead of asking every reader in turn
+	const QByteArray header = device->peek(77);
+	if (header.startsWith("PK\x03\x04")) {
+		if (header.right(47) == "mimetypeapplication/vnd.oasis.opendocument.text") {
+			return QLatin1String("odt");
+		}
+		return QLatin1String("docx");
+	} else if (header.startsWith("{\\rtf")) {
+		return QLatin1String("rtf");
+	}
+	return QLatin1String("txt");
+}
+
+//-----------------------------------------------------------------------------
+
 QString FormatManager::filter(const QString& type)
 {
 	if (type == "odt") {
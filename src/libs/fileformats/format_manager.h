@@ -33,6 +33,7 @@ class FormatManager
 {
 public:
 	static FormatReader* createReader(QIODevice* device, const QString& type = QString());
+	static QString detectType(QIODevice* device);
 	static QString filter(const QString& type);
 	static QStringList filters(const QString& type = QString());
 	static bool isRichText(const QString& filename);
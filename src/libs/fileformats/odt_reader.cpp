@@ -21,6 +21,7 @@
 
 #include "qtzip/QtZipReader"
 
+#include <QScopedPointer>
 #include <QTextDocument>
 
 namespace {
@@ -61,17 +62,21 @@ void OdtReader::readData(QIODevice* device)
 	if (zip.isReadable()) {
 		const QString files[] = { QString::fromLatin1("styles.xml"), QString::fromLatin1("content.xml") };
 		for (int i = 0; i < 2; ++i) {
-			QByteArray data = zip.fileData(files[i]);
-			if (data.isEmpty()) {
+			// Parse while inflating instead of unpacking the whole file first
+			QScopedPointer<QIODevice> data(zip.fileDevice(files[i]));
+			if (data.isNull() || data->atEnd()) {
 				continue;
 			}
-			m_xml.addData(data);
+			m_xml.setDevice(data.data());
 			readDocument();
-			if (m_xml.hasError()) {
+			const bool hasError = m_xml.hasError();
+			if (hasError) {
 				m_error = m_xml.errorString();
-				break;
 			}
 			m_xml.clear();
+			if (hasError) {
+				break;
+			}
 		}
 	} else {
 		m_error = tr("Unable to open archive.");
@@ -41,13 +41,23 @@
 
 #include "qtzipreader.h"
 #include "qtzipwriter.h"
+#include <QBuffer>
 #include <QDateTime>
 #include <QDir>
+#include <QFileDevice>
+#include <QFuture>
+#include <QHash>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QThread>
+#include <QtConcurrent>
 #include <QtDebug>
 #include <QtEndian>
 #include <QtGlobal>
 #include <qplatformdefs.h>
 
+#include <limits>
+
 #ifndef Q_OS_WIN
 #include <zlib.h>
 #else
@@ -196,68 +206,52 @@ static quint32 permissionsToMode(QFile::Permissions perms)
 	return mode;
 }
 
-static int inflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
+// Deflates one block of a file. Blocks are deflated independently, so they can be
+// compressed in parallel: every block but the last one ends with a sync flush, so
+// the blocks written one after another form a single raw deflate stream. The tail
+// of the previous block is used as a dictionary to keep the compression ratio.
+static bool deflateData(QByteArray &dest, const QByteArray &source, const QByteArray &dictionary, bool last, int level)
 {
 	z_stream stream;
-	int err;
-
-	stream.next_in = (Bytef*)source;
-	stream.avail_in = (uInt)sourceLen;
-	if ((uLong)stream.avail_in != sourceLen)
-		return Z_BUF_ERROR;
-
-	stream.next_out = dest;
-	stream.avail_out = (uInt)*destLen;
-	if ((uLong)stream.avail_out != *destLen)
-		return Z_BUF_ERROR;
-
-	stream.zalloc = (alloc_func)0;
-	stream.zfree = (free_func)0;
-
-	err = inflateInit2(&stream, -MAX_WBITS);
-	if (err != Z_OK)
-		return err;
-
-	err = inflate(&stream, Z_FINISH);
-	if (err != Z_STREAM_END) {
-		inflateEnd(&stream);
-		if (err == Z_NEED_DICT || (err == Z_BUF_ERROR && stream.avail_in == 0))
-			return Z_DATA_ERROR;
-		return err;
-	}
-	*destLen = stream.total_out;
-
-	err = inflateEnd(&stream);
-	return err;
+	memset(&stream, 0, sizeof(z_stream));
+	if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	if (!dictionary.isEmpty())
+		deflateSetDictionary(&stream, (const Bytef*)dictionary.constData(), dictionary.size());
+
+	// sync flush marker is not included in the bound
+	dest.resize(int(deflateBound(&stream, source.size())) + 16);
+	stream.next_in = (Bytef*)source.constData();
+	stream.avail_in = (uInt)source.size();
+	stream.next_out = (Bytef*)dest.data();
+	stream.avail_out = (uInt)dest.size();
+
+	const int err = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+	const bool ok = last ? err == Z_STREAM_END : (err == Z_OK && stream.avail_in == 0);
+	dest.resize(ok ? int(stream.total_out) : 0);
+	deflateEnd(&stream);
+	return ok;
 }
 
-static int deflate (Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
+struct DeflatedBlock
 {
-	z_stream stream;
-	int err;
-
-	stream.next_in = (Bytef*)source;
-	stream.avail_in = (uInt)sourceLen;
-	stream.next_out = dest;
-	stream.avail_out = (uInt)*destLen;
-	if ((uLong)stream.avail_out != *destLen) return Z_BUF_ERROR;
-
-	stream.zalloc = (alloc_func)0;
-	stream.zfree = (free_func)0;
-	stream.opaque = (voidpf)0;
-
-	err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
-	if (err != Z_OK) return err;
-
-	err = deflate(&stream, Z_FINISH);
-	if (err != Z_STREAM_END) {
-		deflateEnd(&stream);
-		return err == Z_OK ? Z_BUF_ERROR : err;
-	}
-	*destLen = stream.total_out;
+	QByteArray data;
+	uint crc;
+	qint64 size;
+	bool ok;
+};
 
-	err = deflateEnd(&stream);
-	return err;
+static DeflatedBlock deflateBlock(const QByteArray &source, const QByteArray &dictionary, bool last)
+{
+	DeflatedBlock block;
+	block.crc = ::crc32(::crc32(0, 0, 0), (const Bytef*)source.constData(), source.size());
+	block.size = source.size();
+	block.ok = deflateData(block.data, source, dictionary, last, Z_DEFAULT_COMPRESSION);
+	// incompressible data is kept in stored deflate blocks
+	if (block.ok && block.data.size() > source.size())
+		block.ok = deflateData(block.data, source, dictionary, last, Z_NO_COMPRESSION);
+	return block;
 }
 
 static QFile::Permissions modeToPermissions(quint32 mode)
@@ -545,10 +539,14 @@ public:
 	}
 
 	void scanFiles();
+	int indexOf(const QString &fileName) const;
 
 	QtZipReader::Status status;
+	QHash<QString, int> fileIndexes;
 };
 
+class QtZipEntrySink;
+
 class QtZipWriterPrivate : public QtZipPrivate
 {
 public:
@@ -556,17 +554,25 @@ public:
 		: QtZipPrivate(device, ownDev),
 		status(QtZipWriter::NoError),
 		permissions(QFile::ReadOwner | QFile::WriteOwner),
-		compressionPolicy(QtZipWriter::AlwaysCompress)
+		compressionPolicy(QtZipWriter::AlwaysCompress),
+		currentEntry(0),
+		end_of_written_data(0)
 	{
 	}
 
 	QtZipWriter::Status status;
 	QFile::Permissions permissions;
 	QtZipWriter::CompressionPolicy compressionPolicy;
+	QtZipEntrySink *currentEntry;
+	// the furthest position written to, aborted entries may leave data past the end of the archive
+	qint64 end_of_written_data;
 
 	enum EntryType { Directory, File, Symlink };
 
 	void addEntry(EntryType type, const QString &fileName, const QByteArray &contents);
+	QtZipEntrySink *beginEntry(EntryType type, const QString &fileName);
+	void finishEntry(const FileHeader &header);
+	void abortEntry(const FileHeader &header);
 };
 
 LocalFileHeader CentralFileHeader::toLocalHeader() const
@@ -670,10 +676,175 @@ void QtZipReaderPrivate::scanFiles()
 		}
 
 		ZDEBUG("found file '%s'", header.file_name.data());
+		const QString fileName = QString::fromLocal8Bit(header.file_name);
+		if (!fileIndexes.contains(fileName))
+			fileIndexes.insert(fileName, fileHeaders.size());
 		fileHeaders.append(header);
 	}
 }
 
+int QtZipReaderPrivate::indexOf(const QString &fileName) const
+{
+	return fileIndexes.value(fileName, -1);
+}
+
+// Compresses the data written to it and writes it to the archive. The data is
+// split into blocks, which are deflated in the thread pool, so the memory used
+// doesn't depend on the file size and big files are compressed by all cores.
+class QtZipEntrySink : public QIODevice
+{
+public:
+	QtZipEntrySink(QtZipWriterPrivate *writer, const FileHeader &header, QtZipWriter::CompressionPolicy policy)
+		: writer(writer), header(header), policy(policy), crc(::crc32(0, 0, 0)), size(0),
+		  compressedSize(0), submittedBlocks(0), maxQueuedBlocks(qMax(2, QThread::idealThreadCount() * 2)),
+		  failed(false)
+	{
+	}
+
+	~QtZipEntrySink()
+	{
+		close();
+	}
+
+	bool isSequential() const
+	{
+		return true;
+	}
+
+	void close()
+	{
+		if (isOpen() && !finish())
+			setErrorString(QLatin1String("QtZip: failed to write the file to the archive"));
+		QIODevice::close();
+	}
+
+protected:
+	qint64 readData(char *, qint64)
+	{
+		return -1;
+	}
+
+	qint64 writeData(const char *data, qint64 len)
+	{
+		if (failed)
+			return -1;
+
+		if (policy == QtZipWriter::NeverCompress) {
+			crc = ::crc32(crc, (const Bytef*)data, (uInt)len);
+			size += len;
+			return writeCompressed(QByteArray::fromRawData(data, int(len))) ? len : -1;
+		}
+
+		// cut the data into blocks, so big writes are compressed in parallel too
+		qint64 written = 0;
+		while (written < len) {
+			const int chunk = int(qMin(len - written, qint64(BlockSize - pending.size())));
+			pending.append(data + written, chunk);
+			written += chunk;
+			if (pending.size() == BlockSize && !submitBlock(false))
+				return -1;
+		}
+		return len;
+	}
+
+private:
+	enum { BlockSize = 256 * 1024, DictionarySize = 32 * 1024 };
+
+	bool submitBlock(bool last)
+	{
+		blocks.enqueue(QtConcurrent::run(deflateBlock, pending, dictionary, last));
+		++submittedBlocks;
+		dictionary = pending.right(DictionarySize);
+		pending.clear();
+
+		// don't let the compressed blocks pile up in memory
+		while (blocks.size() > maxQueuedBlocks)
+			writeBlock(blocks.dequeue().result());
+		return !failed;
+	}
+
+	void writeBlock(const DeflatedBlock &block)
+	{
+		if (failed)
+			return;
+		if (!block.ok) {
+			qWarning("QtZip: Failed to compress file");
+			writer->status = QtZipWriter::FileError;
+			failed = true;
+			return;
+		}
+		crc = ::crc32_combine(crc, block.crc, block.size);
+		size += block.size;
+		writeCompressed(block.data);
+	}
+
+	bool writeCompressed(const QByteArray &data)
+	{
+		if (writer->device->write(data) != data.size()) {
+			writer->status = QtZipWriter::FileWriteError;
+			failed = true;
+			return false;
+		}
+		compressedSize += data.size();
+		return true;
+	}
+
+	bool finish()
+	{
+		CompressionMethod method = CompressionMethodDeflated;
+		if (failed) {
+			// nothing more is written, but the started blocks have to be finished
+		} else if (policy == QtZipWriter::NeverCompress) {
+			method = CompressionMethodStored;
+		} else if (submittedBlocks == 0) {
+			// the whole file fits in one block, so store it as is if compression doesn't help
+			const DeflatedBlock block = deflateBlock(pending, QByteArray(), true);
+			crc = block.crc;
+			size = block.size;
+			// don't compress small files
+			const bool isSmall = policy == QtZipWriter::AutoCompress && pending.size() < 64;
+			if (isSmall || !block.ok || block.data.size() >= pending.size()) {
+				method = CompressionMethodStored;
+				writeCompressed(pending);
+			} else {
+				writeCompressed(block.data);
+			}
+		} else {
+			submitBlock(true);
+		}
+		while (!blocks.isEmpty())
+			writeBlock(blocks.dequeue().result());
+		pending.clear();
+		dictionary.clear();
+
+		// a broken entry must not get into the central directory
+		if (failed) {
+			writer->abortEntry(header);
+			return false;
+		}
+
+		writeUShort(header.h.compression_method, method);
+		writeUInt(header.h.crc_32, crc);
+		writeUInt(header.h.compressed_size, compressedSize);
+		writeUInt(header.h.uncompressed_size, size);
+		writer->finishEntry(header);
+		return true;
+	}
+
+	QtZipWriterPrivate *writer;
+	FileHeader header;
+	QtZipWriter::CompressionPolicy policy;
+	uint crc;
+	qint64 size;
+	qint64 compressedSize;
+	int submittedBlocks;
+	int maxQueuedBlocks;
+	bool failed;
+	QByteArray pending;
+	QByteArray dictionary;
+	QQueue<QFuture<DeflatedBlock> > blocks;
+};
+
 void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QtZip::Method m*/)
 {
 #ifndef NDEBUG
@@ -684,59 +855,33 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 	ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
 #endif
 
-	if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
-		status = QtZipWriter::FileOpenError;
+	QScopedPointer<QtZipEntrySink> entry(beginEntry(type, fileName));
+	if (entry.isNull())
 		return;
+
+	entry->write(contents);
+	entry->close();
+}
+
+QtZipEntrySink *QtZipWriterPrivate::beginEntry(EntryType type, const QString &fileName)
+{
+	if (currentEntry != 0) {
+		qWarning("QtZip: Previous file is not finished, finishing it before adding the next one");
+		currentEntry->close();
 	}
-	device->seek(start_of_directory);
 
-	// don't compress small files
-	QtZipWriter::CompressionPolicy compression = compressionPolicy;
-	if (compressionPolicy == QtZipWriter::AutoCompress) {
-		if (contents.length() < 64)
-			compression = QtZipWriter::NeverCompress;
-		else
-			compression = QtZipWriter::AlwaysCompress;
+	if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
+		status = QtZipWriter::FileOpenError;
+		return 0;
 	}
+	device->seek(start_of_directory);
 
 	FileHeader header;
 	memset(&header.h, 0, sizeof(CentralFileHeader));
 	writeUInt(header.h.signature, 0x02014b50);
 
 	writeUShort(header.h.version_needed, ZIP_VERSION);
-	writeUInt(header.h.uncompressed_size, contents.length());
 	writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
-	QByteArray data = contents;
-	if (compression == QtZipWriter::AlwaysCompress) {
-		writeUShort(header.h.compression_method, CompressionMethodDeflated);
-
-	   ulong len = contents.length();
-		// shamelessly copied form zlib
-		len += (len >> 12) + (len >> 14) + 11;
-		int res;
-		do {
-			data.resize(len);
-			res = deflate((uchar*)data.data(), &len, (const uchar*)contents.constData(), contents.length());
-
-			switch (res) {
-			case Z_OK:
-				data.resize(len);
-				break;
-			case Z_MEM_ERROR:
-				qWarning("QtZip: Z_MEM_ERROR: Not enough memory to compress file, skipping");
-				data.resize(0);
-				break;
-			case Z_BUF_ERROR:
-				len *= 2;
-				break;
-			}
-		} while (res == Z_BUF_ERROR);
-	}
-// TODO add a check if data.length() > contents.length().  Then try to store the original and revert the compression method to be uncompressed
-	writeUInt(header.h.compressed_size, data.length());
-	uint crc_32 = ::crc32(0, 0, 0);
-	crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
-	writeUInt(header.h.crc_32, crc_32);
 
 	// if bit 11 is set, the filename and comment fields must be encoded using UTF-8
 	ushort general_purpose_bits = Utf8Names; // always use utf-8
@@ -767,17 +912,187 @@ void QtZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
 	writeUInt(header.h.external_file_attributes, mode << 16);
 	writeUInt(header.h.offset_local_header, start_of_directory);
 
+	// sizes and checksum are not known yet, the local header is rewritten when the entry is finished
+	LocalFileHeader h = header.h.toLocalHeader();
+	device->write((const char *)&h, sizeof(LocalFileHeader));
+	device->write(header.file_name);
 
-	fileHeaders.append(header);
+	QtZipEntrySink *entry = new QtZipEntrySink(this, header, compressionPolicy);
+	entry->open(QIODevice::WriteOnly);
+	currentEntry = entry;
+	return entry;
+}
 
+void QtZipWriterPrivate::finishEntry(const FileHeader &header)
+{
+	const qint64 end = device->pos();
 	LocalFileHeader h = header.h.toLocalHeader();
+	device->seek(readUInt(header.h.offset_local_header));
 	device->write((const char *)&h, sizeof(LocalFileHeader));
-	device->write(header.file_name);
-	device->write(data);
-	start_of_directory = device->pos();
+	device->seek(end);
+
+	fileHeaders.append(header);
+	start_of_directory = end;
 	dirtyFileTree = true;
+	currentEntry = 0;
 }
 
+void QtZipWriterPrivate::abortEntry(const FileHeader &header)
+{
+	// the next entry or the central directory overwrites what was written
+	end_of_written_data = qMax(end_of_written_data, device->pos());
+	start_of_directory = readUInt(header.h.offset_local_header);
+	device->seek(start_of_directory);
+	currentEntry = 0;
+}
+
+// Reads a single archive entry, inflating it incrementally, so the whole
+// uncompressed (or compressed) entry is never held in memory at once.
+class QtZipEntryDevice : public QIODevice
+{
+public:
+	QtZipEntryDevice(QIODevice *archive, qint64 dataStart, qint64 compressedSize,
+					 qint64 uncompressedSize, int compressionMethod)
+		: archive(archive), inputPos(dataStart), inputRemaining(compressedSize),
+		  uncompressedSize(uncompressedSize), produced(0),
+		  compressionMethod(compressionMethod), streamInitialized(false), streamEnded(false)
+	{
+		memset(&stream, 0, sizeof(z_stream));
+	}
+
+	~QtZipEntryDevice()
+	{
+		close();
+	}
+
+	bool open(OpenMode mode)
+	{
+		if ((mode & QIODevice::WriteOnly) != 0)
+			return false;
+
+		if (compressionMethod == CompressionMethodDeflated) {
+			if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+				setErrorString(QLatin1String("QtZip: failed to initialize the inflate stream"));
+				return false;
+			}
+			streamInitialized = true;
+			inputBuffer.resize(InputChunkSize);
+		}
+		return QIODevice::open(mode);
+	}
+
+	void close()
+	{
+		if (streamInitialized) {
+			inflateEnd(&stream);
+			streamInitialized = false;
+		}
+		inputBuffer.clear();
+		QIODevice::close();
+	}
+
+	bool isSequential() const
+	{
+		return true;
+	}
+
+	qint64 size() const
+	{
+		return uncompressedSize;
+	}
+
+	qint64 bytesAvailable() const
+	{
+		return qMax(uncompressedSize - produced, qint64(0)) + QIODevice::bytesAvailable();
+	}
+
+protected:
+	qint64 readData(char *data, qint64 maxSize)
+	{
+		if (compressionMethod == CompressionMethodStored) {
+			const qint64 toRead = qMin(maxSize, qMin(inputRemaining, uncompressedSize - produced));
+			if (toRead <= 0)
+				return 0;
+			if (!archive->seek(inputPos))
+				return -1;
+			const qint64 read = archive->read(data, toRead);
+			if (read > 0) {
+				inputPos += read;
+				inputRemaining -= read;
+				produced += read;
+			}
+			return read;
+		}
+
+		if (streamEnded)
+			return 0;
+
+		stream.next_out = (Bytef*)data;
+		stream.avail_out = (uInt)qMin(maxSize, qint64(std::numeric_limits<uInt>::max()));
+		const uInt requested = stream.avail_out;
+		while (stream.avail_out > 0 && !streamEnded) {
+			if (stream.avail_in == 0) {
+				if (inputRemaining == 0)
+					break;
+				// the archive device can be shared by several entries, so always seek
+				if (!archive->seek(inputPos))
+					return -1;
+				const qint64 read = archive->read(inputBuffer.data(), qMin(qint64(inputBuffer.size()), inputRemaining));
+				if (read <= 0) {
+					qWarning("QtZip: Failed to read compressed data");
+					return -1;
+				}
+				inputPos += read;
+				inputRemaining -= read;
+				stream.next_in = (Bytef*)inputBuffer.constData();
+				stream.avail_in = (uInt)read;
+			}
+
+			const int res = ::inflate(&stream, Z_NO_FLUSH);
+			if (res == Z_STREAM_END) {
+				streamEnded = true;
+			} else if (res == Z_BUF_ERROR && stream.avail_in == 0) {
+				continue;
+			} else if (res != Z_OK) {
+				switch (res) {
+				case Z_MEM_ERROR:
+					qWarning("QtZip: Z_MEM_ERROR: Not enough memory");
+					break;
+				case Z_NEED_DICT:
+				case Z_DATA_ERROR:
+					qWarning("QtZip: Z_DATA_ERROR: Input data is corrupted");
+					break;
+				}
+				setErrorString(QLatin1String("QtZip: failed to inflate the entry"));
+				return -1;
+			}
+		}
+
+		const qint64 read = requested - stream.avail_out;
+		produced += read;
+		return read;
+	}
+
+	qint64 writeData(const char *, qint64)
+	{
+		return -1;
+	}
+
+private:
+	enum { InputChunkSize = 16 * 1024 };
+
+	QIODevice *archive;
+	qint64 inputPos;
+	qint64 inputRemaining;
+	qint64 uncompressedSize;
+	qint64 produced;
+	int compressionMethod;
+	z_stream stream;
+	bool streamInitialized;
+	bool streamEnded;
+	QByteArray inputBuffer;
+};
+
 //////////////////////////////  Reader
 
 /*!
@@ -977,82 +1292,73 @@ QtZipReader::FileInfo QtZipReader::entryInfoAt(int index) const
 */
 QByteArray QtZipReader::fileData(const QString &fileName) const
 {
-	d->scanFiles();
-	int i;
-	for (i = 0; i < d->fileHeaders.size(); ++i) {
-		if (QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
-			break;
-	}
-	if (i == d->fileHeaders.size())
+	QScopedPointer<QIODevice> entry(fileDevice(fileName));
+	if (entry.isNull())
 		return QByteArray();
 
-	FileHeader header = d->fileHeaders.at(i);
+	QByteArray data;
+	data.reserve(int(entry->size()));
+	char buffer[16 * 1024];
+	qint64 read = 0;
+	while ((read = entry->read(buffer, sizeof(buffer))) > 0)
+		data.append(buffer, int(read));
+	return data;
+}
+
+/*!
+	Return a device, which reads the file contents from the zip archive and
+	inflates them on the fly, so the file can be processed while it is being
+	uncompressed. The returned device is already open, the caller takes
+	ownership of it. Returns 0 if the file is not found or can't be extracted.
+	\note The device reads from device() and is valid only until it is closed.
+*/
+QIODevice *QtZipReader::fileDevice(const QString &fileName) const
+{
+	d->scanFiles();
+	const int i = d->indexOf(fileName);
+	if (i == -1)
+		return 0;
+
+	const FileHeader &header = d->fileHeaders.at(i);
 
 	ushort version_needed = readUShort(header.h.version_needed);
 	if (version_needed > ZIP_VERSION) {
 		qWarning("QtZip: .ZIP specification version %d implementationis needed to extract the data.", version_needed);
-		return QByteArray();
+		return 0;
 	}
 
 	ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
-	int compressed_size = readUInt(header.h.compressed_size);
-	int uncompressed_size = readUInt(header.h.uncompressed_size);
-	int start = readUInt(header.h.offset_local_header);
-	//qDebug("uncompressing file %d: local header at %d", i, start);
-
-	d->device->seek(start);
-	LocalFileHeader lh;
-	d->device->read((char *)&lh, sizeof(LocalFileHeader));
-	uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
-	d->device->seek(d->device->pos() + skip);
-
-	int compression_method = readUShort(lh.compression_method);
-	//qDebug("file=%s: compressed_size=%d, uncompressed_size=%d", fileName.toLocal8Bit().data(), compressed_size, uncompressed_size);
-
 	if ((general_purpose_bits & Encrypted) != 0) {
 		qWarning("QtZip: Unsupported encryption method is needed to extract the data.");
-		return QByteArray();
+		return 0;
 	}
 
-	//qDebug("file at %lld", d->device->pos());
-	QByteArray compressed = d->device->read(compressed_size);
-	if (compression_method == CompressionMethodStored) {
-		// no compression
-		compressed.truncate(uncompressed_size);
-		return compressed;
-	} else if (compression_method == CompressionMethodDeflated) {
-		// Deflate
-		//qDebug("compressed=%d", compressed.size());
-		compressed.truncate(compressed_size);
-		QByteArray baunzip;
-		ulong len = qMax(uncompressed_size,  1);
-		int res;
-		do {
-			baunzip.resize(len);
-			res = inflate((uchar*)baunzip.data(), &len,
-						  (uchar*)compressed.constData(), compressed_size);
-
-			switch (res) {
-			case Z_OK:
-				if ((int)len != baunzip.size())
-					baunzip.resize(len);
-				break;
-			case Z_MEM_ERROR:
-				qWarning("QtZip: Z_MEM_ERROR: Not enough memory");
-				break;
-			case Z_BUF_ERROR:
-				len *= 2;
-				break;
-			case Z_DATA_ERROR:
-				qWarning("QtZip: Z_DATA_ERROR: Input data is corrupted");
-				break;
-			}
-		} while (res == Z_BUF_ERROR);
-		return baunzip;
+	const qint64 compressed_size = readUInt(header.h.compressed_size);
+	const qint64 uncompressed_size = readUInt(header.h.uncompressed_size);
+	const qint64 start = readUInt(header.h.offset_local_header);
+	//qDebug("uncompressing file %d: local header at %lld", i, start);
+
+	d->device->seek(start);
+	LocalFileHeader lh;
+	if (d->device->read((char *)&lh, sizeof(LocalFileHeader)) != (qint64)sizeof(LocalFileHeader)) {
+		qWarning("QtZip: Failed to read local file header");
+		return 0;
+	}
+	const uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
+	const qint64 dataStart = d->device->pos() + skip;
+
+	const int compression_method = readUShort(lh.compression_method);
+	if (compression_method != CompressionMethodStored
+		&& compression_method != CompressionMethodDeflated) {
+		qWarning("QtZip: Unsupported compression method %d is needed to extract the data.", compression_method);
+		return 0;
 	}
 
-	qWarning("QtZip: Unsupported compression method %d is needed to extract the data.", compression_method);
-	return QByteArray();
+	QScopedPointer<QtZipEntryDevice> entry(
+		new QtZipEntryDevice(d->device, dataStart, compressed_size, uncompressed_size, compression_method));
+	if (!entry->open(QIODevice::ReadOnly))
+		return 0;
+	return entry.take();
 }
 
 /*!
@@ -1353,6 +1659,18 @@ void QtZipWriter::addFile(const QString &fileName, QIODevice *device)
 		device->close();
 }
 
+/*!
+	Return a device, data written to which is compressed on the fly and stored
+	in the archive as the file \a fileName. The file is finished when the device
+	is closed, only one file can be written at a time. The returned device is
+	already open, the caller takes ownership of it.
+	Returns 0 if the archive can't be written.
+*/
+QIODevice *QtZipWriter::fileDevice(const QString &fileName)
+{
+	return d->beginEntry(QtZipWriterPrivate::File, QDir::fromNativeSeparators(fileName));
+}
+
 /*!
 	Create a new directory in the archive with the specified \a dirName and
 	the \a permissions;
@@ -1381,6 +1699,9 @@ void QtZipWriter::addSymLink(const QString &fileName, const QString &destination
 */
 void QtZipWriter::close()
 {
+	if (d->currentEntry != 0)
+		d->currentEntry->close();
+
 	if (!(d->device->openMode() & QIODevice::WriteOnly)) {
 		d->device->close();
 		return;
@@ -1411,5 +1732,18 @@ void QtZipWriter::close()
 
 	d->device->write((const char *)&eod, sizeof(EndOfDirectory));
 	d->device->write(d->comment);
+	// drop the remains of aborted entries, if any
+	const qint64 end_of_archive = d->device->pos();
+	if (d->end_of_written_data > end_of_archive) {
+		if (QFileDevice *f = qobject_cast<QFileDevice*>(d->device)) {
+			if (!f->resize(end_of_archive))
+				d->status = QtZipWriter::FileWriteError;
+		} else if (QBuffer *b = qobject_cast<QBuffer*>(d->device)) {
+			b->buffer().truncate(int(end_of_archive));
+		} else {
+			qWarning("QtZip: Unable to drop the remains of an aborted file from the device");
+			d->status = QtZipWriter::FileWriteError;
+		}
+	}
 	d->device->close();
 }
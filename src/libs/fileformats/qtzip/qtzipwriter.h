@@ -85,6 +85,8 @@ public:
 
 	void addFile(const QString &fileName, QIODevice *device);
 
+	QIODevice *fileDevice(const QString &fileName);
+
 	void addDirectory(const QString &dirName);
 
 	void addSymLink(const QString &fileName, const QString &destination);
@@ -25,6 +25,7 @@
 #include "rtf_reader.h"
 
 #include <QFile>
+#include <QMutex>
 #include <QTextBlock>
 #include <QTextCodec>
 #include <QTextDecoder>
@@ -33,9 +34,13 @@
 
 namespace
 {
-	QTextCodec* codecForCodePage(qint32 value, QByteArray* codepage = 0)
+	QByteArray codePageName(qint32 value)
+	{
+		return "CP" + QByteArray::number(value);
+	}
+
+	QTextCodec* codecForCodePage(qint32 value)
 	{
-		QByteArray name = "CP" + QByteArray::number(value);
 		QByteArray codec;
 		if (value == 932) {
 			codec = "Shift-JIS";
@@ -44,14 +49,14 @@ namespace
 		} else if (value == 65001) {
 			codec = "UTF-8";
 		} else {
-			codec = name;
-		}
-		if (codepage) {
-			*codepage = name;
+			codec = codePageName(value);
 		}
 		return QTextCodec::codecForName(codec);
 	}
 
+	// Function tables are shared by all readers, which can work in different threads
+	QMutex function_tables_mutex;
+
 	qreal pixelsFromTwips(qint32 _twips)
 	{
 		qreal inches = _twips / 1440.0;
@@ -150,9 +155,13 @@ heading_functions;
 
 RtfReader::RtfReader() :
 	m_in_block(true),
+	m_stylesheet_group_end(0),
+	m_text_insert_count(0),
 	m_codec(0),
 	m_decoder(0)
 {
+	QMutexLocker function_tables_locker(&function_tables_mutex);
+
 	if (functions.isEmpty()) {
 		functions.setInsertText(&RtfReader::insertText);
 
@@ -254,6 +263,7 @@ RtfReader::RtfReader() :
 		stylesheet_functions.set("s", &RtfReader::setStyleId, 0);
 		stylesheet_functions.set("sbasedon", &RtfReader::setStyleParent, 0);
 		stylesheet_functions.setInsertText(&RtfReader::setStyleName);
+		stylesheet_functions.setGroupEnd(&RtfReader::endStyleSheetGroup);
 
 		stylesheet_functions.set("qc", &RtfReader::setBlockAlignment, Qt::AlignHCenter);
 		stylesheet_functions.set("qj", &RtfReader::setBlockAlignment, Qt::AlignJustify);
@@ -296,6 +306,8 @@ RtfReader::RtfReader() :
 		heading_functions.unset("b");
 	}
 
+	function_tables_locker.unlock();
+
 	m_state.ignore_control_word = false;
 	m_state.ignore_text = false;
 	m_state.skip = 1;
@@ -331,6 +343,7 @@ void RtfReader::readData(QIODevice* device)
 
 		// Open file
 		m_cursor.beginEditBlock();
+		m_text_insert_count = 0;
 		m_token.setDevice(device);
 
 		// Check file type
@@ -350,6 +363,7 @@ void RtfReader::readData(QIODevice* device)
 			m_token.readNext();
 
 			if ((m_token.type() != EndGroupToken) && !m_in_block) {
+				flushText();
 				m_cursor.insertBlock(m_state.block_format);
 				m_in_block = true;
 			}
@@ -372,6 +386,8 @@ void RtfReader::readData(QIODevice* device)
 	} catch (const QString& error) {
 		m_error = error;
 	}
+	flushText();
+	m_token.setDevice(0);
 	m_cursor.endEditBlock();
 }
 
@@ -401,28 +417,49 @@ void RtfReader::ignoreText(qint32)
 
 void RtfReader::insertHexSymbol(qint32)
 {
-	m_cursor.insertText(m_decoder->toUnicode(m_token.hex()));
+	insertText(m_decoder->toUnicode(m_token.hex()));
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::insertSymbol(qint32 value)
 {
-	m_cursor.insertText(QChar(value));
+	insertText(QChar(value));
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::insertText(const QString& text)
 {
-	m_cursor.insertText(text);
+	// Collect text with the same formatting to insert it at once
+	QTextCharFormat format = m_cursor.charFormat();
+	format.clearProperty(QTextFormat::ObjectType);
+	if (!m_pending_text.isEmpty() && (format != m_pending_format)) {
+		flushText();
+	}
+	if (m_pending_text.isEmpty()) {
+		m_pending_format = format;
+	}
+	m_pending_text += text;
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfReader::flushText()
+{
+	if (m_pending_text.isEmpty()) {
+		return;
+	}
+	m_cursor.insertText(m_pending_text, m_pending_format);
+	++m_text_insert_count;
+	m_pending_text.clear();
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::insertUnicodeSymbol(qint32 value)
 {
-	m_cursor.insertText(QChar(value));
+	insertText(QChar(value));
 
 	for (int i = m_state.skip; i > 0;) {
 		m_token.readNext();
@@ -430,7 +467,7 @@ void RtfReader::insertUnicodeSymbol(qint32 value)
 		if (m_token.type() == TextToken) {
 			int len = m_token.text().count();
 			if (len > i) {
-				m_cursor.insertText(m_decoder->toUnicode(m_token.text().mid(i)));
+				insertText(m_decoder->toUnicode(m_token.text().mid(i)));
 				break;
 			} else {
 				i -= len;
@@ -586,11 +623,10 @@ void RtfReader::setSkipCharacters(qint32 value)
 
 void RtfReader::setCodepage(qint32 value)
 {
-	QByteArray codepage;
-	QTextCodec* codec = codecForCodePage(value, &codepage);
+	QTextCodec* codec = cachedCodecForCodePage(value);
 	if (codec != 0) {
 		m_codepage = codec;
-		m_encoding = codepage;
+		m_encoding = codePageName(value);
 		setCodec(codec);
 	}
 }
@@ -623,7 +659,7 @@ void RtfReader::setFontCodepage(qint32 value)
 		return;
 	}
 
-	QTextCodec* codec = codecForCodePage(value);
+	QTextCodec* codec = cachedCodecForCodePage(value);
 	if (codec != 0) {
 		m_codepages[m_state.active_codepage] = codec;
 		setCodec(codec);
@@ -693,6 +729,16 @@ void RtfReader::setCodec(QTextCodec* codec)
 
 //-----------------------------------------------------------------------------
 
+QTextCodec* RtfReader::cachedCodecForCodePage(qint32 value)
+{
+	if (!m_codepage_codecs.contains(value)) {
+		m_codepage_codecs.insert(value, codecForCodePage(value));
+	}
+	return m_codepage_codecs.value(value);
+}
+
+//-----------------------------------------------------------------------------
+
 void RtfReader::setOutlineLevel(qint32 value)
 {
 	m_state.block_format.setProperty(QTextFormat::UserProperty, qBound(1, value + 1, 6));
@@ -729,7 +775,7 @@ void RtfReader::startStyleSheet(qint32)
 void RtfReader::setStyleId(qint32 value)
 {
 	m_state.style = value;
-	stylesheet_functions.setGroupEnd(&RtfReader::setStyleEnd);
+	m_stylesheet_group_end = &RtfReader::setStyleEnd;
 }
 
 //-----------------------------------------------------------------------------
@@ -791,14 +837,23 @@ void RtfReader::setStyleEnd()
 		child.char_format = char_format;
 	}
 
-	stylesheet_functions.setGroupEnd(&RtfReader::setStyleSheetEnd);
+	m_stylesheet_group_end = &RtfReader::setStyleSheetEnd;
 }
 
 //-----------------------------------------------------------------------------
 
 void RtfReader::setStyleSheetEnd()
 {
-	stylesheet_functions.setGroupEnd(0);
+	m_stylesheet_group_end = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfReader::endStyleSheetGroup()
+{
+	if (m_stylesheet_group_end) {
+		(this->*m_stylesheet_group_end)();
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -47,6 +47,12 @@ public:
 
 	static bool canRead(QIODevice* device);
 
+	// Number of text insertions into the document made by the last read, for profiling
+	int textInsertCount() const
+	{
+		return m_text_insert_count;
+	}
+
 private:
 	void readData(QIODevice* device);
 	void endBlock(qint32);
@@ -56,6 +62,7 @@ private:
 	void insertSymbol(qint32 value);
 	void insertUnicodeSymbol(qint32 value);
 	void insertText(const QString& text);
+	void flushText();
 	void pushState();
 	void popState();
 	void resetBlockFormatting(qint32);
@@ -78,6 +85,7 @@ private:
 	void setFontCharset(qint32 value);
 	void setFontCodepage(qint32 value);
 	void setCodec(QTextCodec* codec);
+	QTextCodec* cachedCodecForCodePage(qint32 value);
 	void setOutlineLevel(qint32 value);
 	void setStyle(qint32 value);
 
@@ -87,6 +95,7 @@ private:
 	void setStyleName(const QString& style);
 	void setStyleEnd();
 	void setStyleSheetEnd();
+	void endStyleSheetGroup();
 
 private:
 	RtfTokenizer m_token;
@@ -102,6 +111,7 @@ private:
 		QSet<int> children;
 	};
 	QHash<int, Style> m_styles;
+	void (RtfReader::*m_stylesheet_group_end)();
 
 	struct State
 	{
@@ -118,10 +128,15 @@ private:
 	State m_state;
 	QTextBlockFormat m_block_format;
 
+	QString m_pending_text;
+	QTextCharFormat m_pending_format;
+	int m_text_insert_count;
+
 	QTextCodec* m_codec;
 	QTextDecoder* m_decoder;
 	QTextCodec* m_codepage;
 	QVector<QTextCodec*> m_codepages;
+	QHash<qint32, QTextCodec*> m_codepage_codecs;
 };
 
 #endif
@@ -24,26 +24,101 @@
 
 #include "rtf_tokenizer.h"
 
-#include <QCoreApplication>
-#include <QIODevice>
+#include <QBuffer>
+#include <QFile>
+
+#include <limits>
+
+namespace
+{
+	enum ByteClass
+	{
+		Delimiter = 0x1,
+		Letter = 0x2,
+		Digit = 0x4
+	};
+
+	// Classes of the bytes and the bytes themselves, hex values refer to the latter
+	class ByteTable
+	{
+	public:
+		ByteTable()
+		{
+			for (int i = 0; i < 256; ++i) {
+				m_bytes[i] = char(i);
+				m_classes[i] = 0;
+				if ((i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z')) {
+					m_classes[i] |= Letter;
+				} else if (i >= '0' && i <= '9') {
+					m_classes[i] |= Digit;
+				}
+			}
+			m_classes[uchar('\\')] |= Delimiter;
+			m_classes[uchar('{')] |= Delimiter;
+			m_classes[uchar('}')] |= Delimiter;
+			m_classes[uchar('\r')] |= Delimiter;
+			m_classes[uchar('\n')] |= Delimiter;
+		}
+
+		bool is(char c, ByteClass byteClass) const
+		{
+			return (m_classes[uchar(c)] & byteClass) != 0;
+		}
+
+		const char* byte(uchar value) const
+		{
+			return m_bytes + value;
+		}
+
+	private:
+		uchar m_classes[256];
+		char m_bytes[256];
+	};
+
+	const ByteTable byteTable;
+
+	int hexValue(char c)
+	{
+		if (c >= '0' && c <= '9') {
+			return c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			return c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+}
 
 //-----------------------------------------------------------------------------
 
 RtfTokenizer::RtfTokenizer() :
-	m_device(0),
+	m_mapped_data(0),
+	m_begin(0),
+	m_size(0),
 	m_position(0),
+	m_type(TextToken),
+	m_hex(0),
+	m_has_hex(false),
+	m_text(0),
+	m_text_size(0),
 	m_value(0),
 	m_has_value(false)
 {
-	m_buffer.reserve(8192);
-	m_text.reserve(8192);
 }
 
 //-----------------------------------------------------------------------------
 
-bool RtfTokenizer::hasNext() const
+RtfTokenizer::~RtfTokenizer()
+{
+	reset();
+}
+
+//-----------------------------------------------------------------------------
+
+QByteArray RtfTokenizer::hex() const
 {
-	return (m_position < m_buffer.size() - 1) || !m_device->atEnd();
+	return m_has_hex ? QByteArray::fromRawData(byteTable.byte(m_hex), 1) : QByteArray();
 }
 
 //-----------------------------------------------------------------------------
@@ -52,11 +127,12 @@ void RtfTokenizer::readNext()
 {
 	// Reset values
 	m_type = TextToken;
-	m_hex.clear();
-	m_text.resize(0);
+	m_has_hex = false;
+	m_text = 0;
+	m_text_size = 0;
 	m_value = 0;
 	m_has_value = false;
-	if (!m_device) {
+	if (!m_begin) {
 		return;
 	}
 
@@ -75,26 +151,29 @@ void RtfTokenizer::readNext()
 		m_type = ControlWordToken;
 
 		c = next();
+		m_text = m_begin + m_position - 1;
 
-		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+		if (byteTable.is(c, Letter)) {
 			// Read control word
-			while ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
-				m_text.append(c);
+			while (byteTable.is(c, Letter)) {
 				c = next();
 			}
+			m_text_size = m_begin + m_position - 1 - m_text;
 
-			// Read integer value
+			// Read integer value, overflowed values are treated as zero
 			int sign = (c != '-') ? 1 : -1;
 			if (sign == -1) {
 				c = next();
 			}
-			QByteArray value;
-			while (isdigit(c)) {
-				value.append(c);
+			qint64 value = 0;
+			while (byteTable.is(c, Digit)) {
+				m_has_value = true;
+				if (value <= std::numeric_limits<qint32>::max()) {
+					value = value * 10 + (c - '0');
+				}
 				c = next();
 			}
-			m_has_value = !value.isEmpty();
-			m_value = value.toInt() * sign;
+			m_value = (value <= std::numeric_limits<qint32>::max()) ? qint32(value) * sign : 0;
 
 			// Eat space after control word
 			if (c != ' ') {
@@ -102,59 +181,110 @@ void RtfTokenizer::readNext()
 			}
 
 			// Eat binary value
-			if (m_text == "bin") {
+			if (m_text_size == 3 && qstrncmp(m_text, "bin", 3) == 0) {
 				if (m_value > 0) {
-					for (int i = 0; i < m_value; i++) {
-						c = next();
+					if (m_value > m_size - m_position) {
+						throw tr("Unexpectedly reached end of file.");
 					}
+					m_position += m_value;
 				}
 				return readNext();
 			}
 		} else if (c == '\'') {
 			// Read hexadecimal value
-			m_text.append(c);
-			QByteArray hex(2, 0);
-			hex[0] = next();
-			hex[1] = next();
-			m_hex.append(hex.toInt(0, 16));
+			m_text_size = 1;
+			const int high = hexValue(next());
+			const int low = hexValue(next());
+			m_hex = (high != -1 && low != -1) ? uchar(high * 16 + low) : 0;
+			m_has_hex = true;
 		} else {
 			// Read escaped character
-			m_text.append(c);
+			m_text_size = 1;
 		}
 	} else {
-		// Read text
+		// Read text up to the next delimiter
 		m_type = TextToken;
-		while (c != '\\' && c != '{' && c != '}' && c != '\n' && c != '\r') {
-			m_text.append(c);
-			c = next();
+		m_text = m_begin + m_position - 1;
+		const char* end = m_begin + m_size;
+		const char* text_end = m_text + 1;
+		while (text_end < end && !byteTable.is(*text_end, Delimiter)) {
+			++text_end;
 		}
-		m_position--;
+		if (text_end == end) {
+			throw tr("Unexpectedly reached end of file.");
+		}
+		m_text_size = text_end - m_text;
+		m_position = text_end - m_begin;
 	}
 }
 
 //-----------------------------------------------------------------------------
 
+void RtfTokenizer::setData(const QByteArray& data)
+{
+	reset();
+	m_data = data;
+	m_begin = m_data.constData();
+	m_size = m_data.size();
+}
+
+//-----------------------------------------------------------------------------
+
 void RtfTokenizer::setDevice(QIODevice* device)
 {
-	m_device = device;
+	reset();
+	if (!device) {
+		return;
+	}
+
+	// Map files into memory instead of reading them
+	QFile* file = qobject_cast<QFile*>(device);
+	if (file && !file->isSequential()) {
+		const qint64 size = file->size() - file->pos();
+		if (size > 0 && size <= std::numeric_limits<int>::max()) {
+			uchar* data = file->map(file->pos(), size);
+			if (data) {
+				m_mapped_file = file;
+				m_mapped_data = data;
+				m_begin = reinterpret_cast<const char*>(data);
+				m_size = int(size);
+				return;
+			}
+		}
+	}
+
+	// Buffers are used without copying, other devices are read at once
+	QBuffer* buffer = qobject_cast<QBuffer*>(device);
+	if (buffer) {
+		setData(buffer->data().mid(int(buffer->pos())));
+	} else {
+		setData(device->readAll());
+	}
 }
 
 //-----------------------------------------------------------------------------
 
 char RtfTokenizer::next()
 {
-	m_position++;
-	if (m_position >= m_buffer.size()) {
-		m_buffer.resize(8192);
-		int size = m_device->read(m_buffer.data(), m_buffer.size());
-		if (size < 1) {
-			throw tr("Unexpectedly reached end of file.");
-		}
-		m_buffer.resize(size);
-		m_position = 0;
-		QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+	if (m_position >= m_size) {
+		throw tr("Unexpectedly reached end of file.");
+	}
+	return m_begin[m_position++];
+}
+
+//-----------------------------------------------------------------------------
+
+void RtfTokenizer::reset()
+{
+	if (m_mapped_data && m_mapped_file) {
+		m_mapped_file->unmap(m_mapped_data);
 	}
-	return m_buffer.at(m_position);
+	m_mapped_file = 0;
+	m_mapped_data = 0;
+	m_data.clear();
+	m_begin = 0;
+	m_size = 0;
+	m_position = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -22,6 +22,8 @@
 
 #include <QByteArray>
 #include <QCoreApplication>
+#include <QFile>
+#include <QPointer>
 class QIODevice;
 
 enum RtfTokenType
@@ -32,12 +34,15 @@ enum RtfTokenType
 	TextToken
 };
 
+// Tokens are read from one contiguous buffer, a memory-mapped file when possible,
+// and text() refers directly into it, so it stays valid until the data is changed.
 class RtfTokenizer
 {
 	Q_DECLARE_TR_FUNCTIONS(RtfTokenizer)
 
 public:
 	RtfTokenizer();
+	~RtfTokenizer();
 
 	bool hasNext() const;
 	bool hasValue() const;
@@ -47,36 +52,43 @@ public:
 	qint32 value() const;
 
 	void readNext();
+	void setData(const QByteArray& data);
 	void setDevice(QIODevice* device);
 
 private:
 	char next();
+	void reset();
 
 private:
-	QIODevice* m_device;
-	QByteArray m_buffer;
+	QByteArray m_data;
+	QPointer<QFile> m_mapped_file;
+	uchar* m_mapped_data;
+	const char* m_begin;
+	int m_size;
 	int m_position;
 
 	RtfTokenType m_type;
-	QByteArray m_hex;
-	QByteArray m_text;
+	uchar m_hex;
+	bool m_has_hex;
+	const char* m_text;
+	int m_text_size;
 	qint32 m_value;
 	bool m_has_value;
 };
 
-inline bool RtfTokenizer::hasValue() const
+inline bool RtfTokenizer::hasNext() const
 {
-	return m_has_value;
+	return m_position < m_size;
 }
 
-inline QByteArray RtfTokenizer::hex() const
+inline bool RtfTokenizer::hasValue() const
 {
-	return m_hex;
+	return m_has_value;
 }
 
 inline QByteArray RtfTokenizer::text() const
 {
-	return m_text;
+	return QByteArray::fromRawData(m_text, m_text_size);
 }
 
 inline RtfTokenType RtfTokenizer::type() const
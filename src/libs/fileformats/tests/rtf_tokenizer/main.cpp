@@ -0,0 +1,259 @@
+/***********************************************************************
+ *
+ * Round-trip check and throughput benchmark for RtfTokenizer.
+ *
+ * Every given RTF file, or the bundled sample when none is given, is
+ * tokenized by the current tokenizer and by the reference copy of the
+ * previous one; the token streams must be identical. Then both tokenizers
+ * read a large script built by repeating the file, and their throughput is
+ * reported in MB/s.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "legacy_rtf_tokenizer.h"
+#include "rtf_tokenizer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QVector>
+
+namespace
+{
+	// Size of the script used to measure throughput
+	const int BENCHMARK_SIZE = 64 * 1024 * 1024;
+
+	// Measurements per tokenizer, the best one is reported
+	const int BENCHMARK_RUNS = 3;
+
+	struct Token
+	{
+		RtfTokenType type;
+		QByteArray text;
+		QByteArray hex;
+		qint32 value;
+		bool has_value;
+
+		bool operator==(const Token& other) const
+		{
+			return type == other.type
+				&& text == other.text
+				&& hex == other.hex
+				&& value == other.value
+				&& has_value == other.has_value;
+		}
+	};
+
+	struct TokenStream
+	{
+		QVector<Token> tokens;
+		QString error;
+	};
+
+	// Reads tokens up to the end of the outermost group, as RtfReader does
+	template <typename Tokenizer>
+	TokenStream tokenize(Tokenizer& tokenizer)
+	{
+		TokenStream stream;
+		int depth = 0;
+		try {
+			while (tokenizer.hasNext()) {
+				tokenizer.readNext();
+
+				// Deep copies, since the current tokenizer refers into its buffer
+				Token token;
+				token.type = tokenizer.type();
+				token.text = QByteArray(tokenizer.text().constData(), tokenizer.text().size());
+				token.hex = QByteArray(tokenizer.hex().constData(), tokenizer.hex().size());
+				token.value = tokenizer.value();
+				token.has_value = tokenizer.hasValue();
+				stream.tokens.append(token);
+
+				if (token.type == StartGroupToken) {
+					++depth;
+				} else if (token.type == EndGroupToken && --depth == 0) {
+					break;
+				}
+			}
+		} catch (const QString& error) {
+			stream.error = error;
+		}
+		return stream;
+	}
+
+	// Reads all tokens without keeping them, returns the total size of their text
+	template <typename Tokenizer>
+	qint64 consume(Tokenizer& tokenizer)
+	{
+		qint64 size = 0;
+		int depth = 0;
+		try {
+			while (tokenizer.hasNext()) {
+				tokenizer.readNext();
+				size += tokenizer.text().size();
+				if (tokenizer.type() == StartGroupToken) {
+					++depth;
+				} else if (tokenizer.type() == EndGroupToken && --depth == 0) {
+					break;
+				}
+			}
+		} catch (const QString&) {
+		}
+		return size;
+	}
+
+	QString describe(const Token& token)
+	{
+		static const char* const types[] = { "StartGroup", "EndGroup", "ControlWord", "Text" };
+		return QString("%1 \"%2\" hex=%3 value=%4%5")
+			.arg(types[token.type])
+			.arg(QString::fromLatin1(token.text))
+			.arg(QString::fromLatin1(token.hex.toHex()))
+			.arg(token.value)
+			.arg(token.has_value ? "" : " (none)");
+	}
+
+	bool checkRoundTrip(const QString& path, QTextStream& out)
+	{
+		QFile legacy_file(path);
+		QFile current_file(path);
+		if (!legacy_file.open(QIODevice::ReadOnly) || !current_file.open(QIODevice::ReadOnly)) {
+			out << "FAIL " << path << ": unable to open file" << endl;
+			return false;
+		}
+
+		LegacyRtfTokenizer legacy_tokenizer;
+		legacy_tokenizer.setDevice(&legacy_file);
+		const TokenStream expected = tokenize(legacy_tokenizer);
+
+		RtfTokenizer current_tokenizer;
+		current_tokenizer.setDevice(&current_file);
+		const TokenStream actual = tokenize(current_tokenizer);
+
+		// Tokenizing a contiguous buffer must give the same result as a mapped file
+		RtfTokenizer buffer_tokenizer;
+		legacy_file.seek(0);
+		buffer_tokenizer.setData(legacy_file.readAll());
+		const TokenStream buffered = tokenize(buffer_tokenizer);
+
+		const TokenStream* streams[] = { &actual, &buffered };
+		const char* const sources[] = { "device", "buffer" };
+		for (int i = 0; i < 2; ++i) {
+			const TokenStream& stream = *streams[i];
+			const int count = qMin(expected.tokens.size(), stream.tokens.size());
+			for (int index = 0; index < count; ++index) {
+				if (!(expected.tokens.at(index) == stream.tokens.at(index))) {
+					out << "FAIL " << path << " (" << sources[i] << "): token " << index << endl
+						<< "  expected " << describe(expected.tokens.at(index)) << endl
+						<< "  actual   " << describe(stream.tokens.at(index)) << endl;
+					return false;
+				}
+			}
+			if (expected.tokens.size() != stream.tokens.size() || expected.error.isEmpty() != stream.error.isEmpty()) {
+				out << "FAIL " << path << " (" << sources[i] << "): expected " << expected.tokens.size()
+					<< " tokens" << (expected.error.isEmpty() ? "" : " and an error") << ", got "
+					<< stream.tokens.size() << " tokens" << (stream.error.isEmpty() ? "" : " and an error") << endl;
+				return false;
+			}
+		}
+
+		out << "OK   " << path << ": " << expected.tokens.size() << " identical tokens" << endl;
+		return true;
+	}
+
+	template <typename Tokenizer>
+	double measure(QFile& file)
+	{
+		qint64 best = -1;
+		for (int run = 0; run < BENCHMARK_RUNS; ++run) {
+			file.seek(0);
+			QElapsedTimer timer;
+			timer.start();
+			Tokenizer tokenizer;
+			tokenizer.setDevice(&file);
+			consume(tokenizer);
+			const qint64 elapsed = timer.nsecsElapsed();
+			if (best < 0 || elapsed < best) {
+				best = elapsed;
+			}
+		}
+		return (double(file.size()) / (1024 * 1024)) / (double(qMax(best, qint64(1))) / 1e9);
+	}
+
+	bool benchmark(const QString& path, QTextStream& out)
+	{
+		QFile source(path);
+		if (!source.open(QIODevice::ReadOnly)) {
+			return false;
+		}
+		const QByteArray document = source.readAll();
+		if (document.isEmpty()) {
+			return false;
+		}
+
+		// Wrap repeated copies of the document into one group to get a large script
+		QTemporaryFile script;
+		if (!script.open()) {
+			out << "FAIL unable to create a temporary file" << endl;
+			return false;
+		}
+		script.write("{");
+		for (qint64 size = 0; size < BENCHMARK_SIZE; size += document.size()) {
+			script.write(document);
+		}
+		script.write("}");
+		script.flush();
+
+		const double legacy = measure<LegacyRtfTokenizer>(script);
+		const double current = measure<RtfTokenizer>(script);
+		out << QString("     %1: %2 MB, legacy %3 MB/s, current %4 MB/s, x%5")
+			.arg(path)
+			.arg(script.size() / (1024 * 1024))
+			.arg(legacy, 0, 'f', 1)
+			.arg(current, 0, 'f', 1)
+			.arg(current / legacy, 0, 'f', 2) << endl;
+		return true;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	QTextStream out(stdout);
+
+	QStringList paths = app.arguments().mid(1);
+	if (paths.isEmpty()) {
+		paths.append(":/sample.rtf");
+	}
+
+	bool success = true;
+	for (const QString& path : paths) {
+		success = checkRoundTrip(path, out) && success;
+	}
+	if (!success) {
+		return 1;
+	}
+
+	for (const QString& path : paths) {
+		benchmark(path, out);
+	}
+	return 0;
+}
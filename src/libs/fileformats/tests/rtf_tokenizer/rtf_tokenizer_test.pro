@@ -0,0 +1,44 @@
+TARGET   = rtf_tokenizer_test
+TEMPLATE = app
+
+#
+# Build configuration
+#
+CONFIG += console c++11 warn_on
+CONFIG -= app_bundle
+
+QT -= gui
+
+QMAKE_MAC_SDK = macosx10.13
+
+#
+# Конфигурируем расположение файлов сборки
+#
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../../../../../build/Debug/tests/rtf_tokenizer
+} else {
+    DESTDIR = $$PWD/../../../../../build/Release/tests/rtf_tokenizer
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
+RCC_DIR = $$DESTDIR/.qrc
+UI_DIR = $$DESTDIR/.ui
+#
+
+#
+# Текущий токенизатор собирается вместе с проверкой, чтобы не зависеть от сборки библиотеки
+#
+INCLUDEPATH += $$PWD/../..
+
+HEADERS += \
+    ../../rtf_tokenizer.h \
+    legacy_rtf_tokenizer.h
+
+SOURCES += \
+    ../../rtf_tokenizer.cpp \
+    legacy_rtf_tokenizer.cpp \
+    main.cpp
+
+RESOURCES += \
+    rtf_tokenizer_test.qrc